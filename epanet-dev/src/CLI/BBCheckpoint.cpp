@@ -0,0 +1,193 @@
+// src/CLI/BBCheckpoint.cpp
+
+#include "BBCheckpoint.h"
+#include "BBSolver.h"
+#include "Console.h"
+#include "Profiler.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+const uint32_t CHECKPOINT_MAGIC = 0x4b434242; // "BBCK"
+const int32_t CHECKPOINT_VERSION = 1;
+
+template <typename T> void put(std::ostream &out, T value)
+{
+  out.write((const char *)&value, sizeof(T));
+}
+
+template <typename T> T get(std::istream &in)
+{
+  T value;
+  in.read((char *)&value, sizeof(T));
+  return value;
+}
+} // namespace
+
+BBCheckpoint::BBCheckpoint(const BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef)
+    : config(configRef), constraints(constraintsRef), stats(statsRef)
+{
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  last_save = std::chrono::high_resolution_clock::now();
+}
+
+void BBCheckpoint::save_if_due()
+{
+  if (config.checkpoint_interval <= 0) return;
+  auto now = std::chrono::high_resolution_clock::now();
+  if (std::chrono::duration<double>(now - last_save).count() < config.checkpoint_interval) return;
+  save();
+}
+
+//===============================================================
+// Splits the open part of a task in progress into restartable tasks:
+// the siblings left at each level form a task rooted at that level
+// (starting at the next y value) and, if the current node is feasible,
+// its subtree forms a task rooted at the next level.
+//===============================================================
+void BBCheckpoint::append_frontier(const BBTask &task, std::vector<BBTask> &frontier) const
+{
+  auto add = [&](int h_root, int y_first, double cost_lb)
+  {
+    BBTask open;
+    open.uid = task.uid;
+    open.tid = task.tid;
+    open.num_pumps = task.num_pumps;
+    open.h_root = h_root;
+    open.y_first = y_first;
+    open.cost_lb = cost_lb;
+    open.y.assign(config.h_max + 1, 0);
+    std::copy(task.y.begin(), task.y.begin() + h_root, open.y.begin());
+    frontier.push_back(std::move(open));
+  };
+
+  // The depth-first loop has not started yet, the whole task is restarted
+  if (task.h < task.h_root)
+  {
+    add(task.h_root, task.y_first, task.cost_lb);
+    return;
+  }
+
+  for (int h = task.h_root; h <= std::min(task.h, config.h_max); ++h)
+  {
+    if (task.y[h] < task.num_pumps) add(h, task.y[h] + 1, task.costs[h - 1]);
+  }
+  if (task.is_feasible && task.h < config.h_max) add(task.h + 1, 0, task.costs[task.h]);
+}
+
+void BBCheckpoint::save()
+{
+  ProfileScope scope("checkpoint");
+
+  std::vector<BBTask> frontier;
+  if (current) append_frontier(*current, frontier);
+  if (tasks)
+  {
+    for (size_t i = next; i < tasks->size(); ++i)
+    {
+      if ((*tasks)[i].tid == rank) frontier.push_back((*tasks)[i]);
+    }
+  }
+
+  std::string fn_tmp = std::string(config.fn_checkpoint) + ".tmp";
+  std::ofstream out(fn_tmp, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) throw std::runtime_error("BBCheckpoint: cannot open " + fn_tmp);
+
+  int num_procs;
+  MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+  put<uint32_t>(out, CHECKPOINT_MAGIC);
+  put<int32_t>(out, CHECKPOINT_VERSION);
+  put<int32_t>(out, config.h_max);
+  put<int32_t>(out, config.max_actuations);
+  put<int32_t>(out, constraints.get_num_pumps());
+  put<int32_t>(out, num_procs);
+
+  // Incumbent of this rank
+  put<double>(out, constraints.best_cost_local);
+  put<int32_t>(out, (int32_t)constraints.best_x.size());
+  for (int v : constraints.best_x)
+    put<uint8_t>(out, (uint8_t)v);
+  put<int32_t>(out, (int32_t)constraints.best_y.size());
+  for (int v : constraints.best_y)
+    put<uint8_t>(out, (uint8_t)v);
+
+  stats.write(out);
+
+  // Frontier: y[1, h_root - 1] is all that is needed to rebuild a task
+  put<int32_t>(out, (int32_t)frontier.size());
+  for (const BBTask &task : frontier)
+  {
+    put<int32_t>(out, task.uid);
+    put<int32_t>(out, task.h_root);
+    put<int32_t>(out, task.y_first);
+    put<double>(out, task.cost_lb);
+    for (int h = 1; h < task.h_root; ++h)
+      put<uint8_t>(out, (uint8_t)task.y[h]);
+  }
+
+  out.close();
+  if (!out) throw std::runtime_error("BBCheckpoint: cannot write " + fn_tmp);
+  if (std::rename(fn_tmp.c_str(), config.fn_checkpoint) != 0) throw std::runtime_error("BBCheckpoint: cannot rename " + fn_tmp);
+
+  last_save = std::chrono::high_resolution_clock::now();
+  if (config.verbose)
+  {
+    Console::printf(Console::Color::BRIGHT_GREEN, "💾 Proc %02d: checkpoint with %d open tasks\n", rank, (int)frontier.size());
+  }
+}
+
+void BBCheckpoint::load(std::vector<BBTask> &frontier)
+{
+  std::ifstream in(config.fn_checkpoint, std::ios::binary);
+  if (!in.is_open()) throw std::runtime_error(std::string("BBCheckpoint: cannot open ") + config.fn_checkpoint);
+
+  int num_procs;
+  MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+  if (get<uint32_t>(in) != CHECKPOINT_MAGIC || get<int32_t>(in) != CHECKPOINT_VERSION)
+    throw std::runtime_error(std::string("BBCheckpoint: invalid file ") + config.fn_checkpoint);
+  int h_max = get<int32_t>(in);
+  int max_actuations = get<int32_t>(in);
+  int num_pumps = get<int32_t>(in);
+  int np = get<int32_t>(in);
+  if (h_max != config.h_max || max_actuations != config.max_actuations || num_pumps != constraints.get_num_pumps() || np != num_procs)
+    throw std::runtime_error(std::string("BBCheckpoint: configuration mismatch in ") + config.fn_checkpoint);
+
+  double best_cost = get<double>(in);
+  std::vector<int> best_x(get<int32_t>(in));
+  for (int &v : best_x)
+    v = get<uint8_t>(in);
+  std::vector<int> best_y(get<int32_t>(in));
+  for (int &v : best_y)
+    v = get<uint8_t>(in);
+  if (!best_x.empty()) constraints.update_best(best_cost, best_x, best_y);
+
+  stats.read(in);
+
+  int num_tasks = get<int32_t>(in);
+  frontier.clear();
+  frontier.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i)
+  {
+    BBTask task;
+    task.uid = get<int32_t>(in);
+    task.tid = rank;
+    task.num_pumps = num_pumps;
+    task.h_root = get<int32_t>(in);
+    task.y_first = get<int32_t>(in);
+    task.cost_lb = get<double>(in);
+    task.y.assign(h_max + 1, 0);
+    for (int h = 1; h < task.h_root; ++h)
+      task.y[h] = get<uint8_t>(in);
+    frontier.push_back(std::move(task));
+  }
+  if (!in) throw std::runtime_error(std::string("BBCheckpoint: truncated file ") + config.fn_checkpoint);
+
+  Console::printf(Console::Color::BRIGHT_YELLOW, "Proc %02d resumed %d open tasks, cost(local=%s), nodes=%ld\n", rank, num_tasks,
+                  constraints.fmt_cost(constraints.best_cost_local).c_str(), stats.num_nodes());
+}
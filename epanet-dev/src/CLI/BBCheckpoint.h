@@ -0,0 +1,49 @@
+// src/CLI/BBCheckpoint.h
+#pragma once
+
+#include "BBConfig.h"
+#include "BBConstraints.h"
+#include "BBStatistics.h"
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+class BBTask;
+
+//---------------------------------------------------------------------
+// BBCheckpoint: Saves and restores the open part of the search of a rank.
+//
+// A checkpoint is a compact binary file holding the incumbent, the
+// statistics and the frontier: the tasks not yet started plus the open
+// subtrees of the task in progress. Every frontier entry is stored as its
+// y prefix only; the hydraulic snapshots are recomputed when the task is
+// restarted, so the file stays a few kilobytes long.
+//---------------------------------------------------------------------
+class BBCheckpoint
+{
+public:
+  std::vector<BBTask> *tasks = nullptr; // tasks of the run
+  size_t next = 0;                      // first task not yet started
+  const BBTask *current = nullptr;      // task in progress (nullptr between tasks)
+
+  BBCheckpoint(const BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef);
+
+  // Writes a checkpoint if checkpoint_interval seconds have elapsed since the last one
+  void save_if_due();
+
+  // Writes the checkpoint of this rank (atomically, through a temporary file)
+  void save();
+
+  // Restores the incumbent, the statistics and the frontier of this rank
+  void load(std::vector<BBTask> &frontier);
+
+private:
+  const BBConfig &config;
+  BBConstraints &constraints;
+  BBStatistics &stats;
+  int rank;
+  std::chrono::high_resolution_clock::time_point last_save;
+
+  void append_frontier(const BBTask &task, std::vector<BBTask> &frontier) const;
+};
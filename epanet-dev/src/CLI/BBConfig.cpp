@@ -39,6 +39,13 @@ void BBConfig::generateFilenames()
   {
     throw std::runtime_error("Filename truncation occurred in fn_profile!");
   }
+
+  // Format the checkpoint filename
+  ret = snprintf(fn_checkpoint, sizeof(fn_checkpoint), "%s_ckpt.bin", fn_base);
+  if (ret < 0 || static_cast<size_t>(ret) >= sizeof(fn_checkpoint))
+  {
+    throw std::runtime_error("Filename truncation occurred in fn_checkpoint!");
+  }
 }
 
 BBConfig::BBConfig(int argc, char *argv[])
@@ -64,6 +71,38 @@ BBConfig::BBConfig(int argc, char *argv[])
       max_actuations = std::stoi(argv[++i]);
     else if (arg == "-l" || arg == "--level")
       level = std::stoi(argv[++i]);
+    else if (arg == "--tasks_per_rank")
+      tasks_per_rank = std::stoi(argv[++i]);
+    else if (arg == "--no_heuristics")
+      use_heuristics = false;
+    else if (arg == "--heuristic_iters")
+      heuristic_iters = std::stoi(argv[++i]);
+    else if (arg == "--skeletonize")
+      skeletonize = true;
+    else if (arg == "--time_budget")
+      time_budget = std::stod(argv[++i]);
+    else if (arg == "--node_budget")
+      node_budget = std::stol(argv[++i]);
+    else if (arg == "--gap")
+      gap_target = std::stod(argv[++i]);
+    else if (arg == "--report_interval")
+      report_interval = std::stod(argv[++i]);
+    else if (arg == "--shift")
+      shift = std::stoi(argv[++i]);
+    else if (arg == "--prev_best")
+      fn_prev_best = argv[++i];
+    else if (arg == "--tank_heads")
+      fn_tank_heads = argv[++i];
+    else if (arg == "--checkpoint")
+      checkpoint_interval = std::stod(argv[++i]);
+    else if (arg == "--resume")
+      resume = true;
+  }
+
+  // The rolling horizon only moves forward: a negative shift would index the patterns before their start
+  if (shift < 0)
+  {
+    throw std::runtime_error("Invalid --shift " + std::to_string(shift) + ": must be >= 0");
   }
 
   // Buffers for filenames
@@ -85,8 +124,27 @@ void BBConfig::show() const
   Console::printf(Console::Color::WHITE, "  Max hours:       %d\n", h_max);
   Console::printf(Console::Color::WHITE, "  Max actuations:  %d\n", max_actuations);
   Console::printf(Console::Color::WHITE, "  Level:           %d\n", level);
+  if (tasks_per_rank > 0) Console::printf(Console::Color::WHITE, "  Tasks per rank:  %d (adaptive)\n", tasks_per_rank);
   Console::printf(Console::Color::WHITE, "  Verbose:         %s\n", verbose ? "true" : "false");
+  Console::printf(Console::Color::WHITE, "  Heuristics:      %s (%d iters)\n", use_heuristics ? "true" : "false", heuristic_iters);
+  Console::printf(Console::Color::WHITE, "  Skeletonize:     %s\n", skeletonize ? "true" : "false");
+  if (time_budget > 0 || node_budget > 0 || gap_target > 0)
+  {
+    Console::printf(Console::Color::WHITE, "  Time budget:     %.1f s\n", time_budget);
+    Console::printf(Console::Color::WHITE, "  Node budget:     %ld\n", node_budget);
+    Console::printf(Console::Color::WHITE, "  Gap target:      %.4f\n", gap_target);
+  }
+  if (shift > 0 || !fn_prev_best.empty() || !fn_tank_heads.empty())
+  {
+    Console::printf(Console::Color::WHITE, "  Shift:           %d\n", shift);
+    Console::printf(Console::Color::WHITE, "  Previous best:   %s\n", fn_prev_best.empty() ? "none" : fn_prev_best.c_str());
+    Console::printf(Console::Color::WHITE, "  Tank heads:      %s\n", fn_tank_heads.empty() ? "none" : fn_tank_heads.c_str());
+  }
   Console::printf(Console::Color::WHITE, "  Stats file:      %s\n", fn_stats);
   Console::printf(Console::Color::WHITE, "  Best file:       %s\n", fn_best);
   Console::printf(Console::Color::WHITE, "  Profile file:    %s\n", fn_profile);
+  if (checkpoint_interval > 0 || resume)
+  {
+    Console::printf(Console::Color::WHITE, "  Checkpoint file: %s (every %.1f s%s)\n", fn_checkpoint, checkpoint_interval, resume ? ", resumed" : "");
+  }
 }
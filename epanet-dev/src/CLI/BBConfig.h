@@ -13,11 +13,25 @@ public:
   std::string inpFile;
   int h_max = 24;
   int max_actuations = 3;
-  int level = 5;
+  int level = 5;                  // maximum split depth of the tree into tasks
+  int tasks_per_rank = 32;        // adaptive splitting target (0 = all prefixes of length level)
   bool verbose = false;
+  bool use_heuristics = true;
+  int heuristic_iters = 200;
+  bool skeletonize = false;       // remove elements that do not change the hydraulic solution
+  double time_budget = 0;         // wall-clock budget per rank (seconds, 0 = unlimited)
+  long node_budget = 0;           // nodes processed per rank (0 = unlimited)
+  double gap_target = 0;          // stop once the relative gap is below this value
+  double report_interval = 60;    // seconds between progress reports
+  int shift = 0;                  // rolling horizon: hours elapsed since the patterns start
+  std::string fn_prev_best;       // rolling horizon: best.json of the previous plan
+  std::string fn_tank_heads;      // rolling horizon: measured tank heads (JSON)
+  double checkpoint_interval = 0; // seconds between checkpoints (0 = only when a budget stops the search)
+  bool resume = false;            // restart from the checkpoints of a previous run
   char fn_stats[256];
   char fn_best[256];
   char fn_profile[256];
+  char fn_checkpoint[256];
 
 private:
   void generateFilenames();
@@ -5,14 +5,18 @@
 #include "Profiler.h"
 
 #include "Elements/pattern.h"
+#include "Elements/tank.h"
+#include "Solvers/sparspaksolver.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <mpi.h>
+#include <set>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -25,13 +29,27 @@ BBConstraints::BBConstraints(const BBConfig &config)
   tanks = {{"65", 0}, {"165", 0}, {"265", 0}};
   pumps = {{"111", 0}, {"222", 0}, {"333", 0}};
   best_cost_local = std::numeric_limits<double>::max();
+  inpFile = config.inpFile;
+  h_max = config.h_max;
+  shift = config.shift;
+  skeletonize = config.skeletonize;
+  symbolic_factor = std::make_shared<SymbolicFactor>();
+  demand_table = std::make_shared<DemandTableCache>();
 
   // Retrieve node and tank IDs from the input file
   get_network_elements_indices(config.inpFile);
 
+  // Measured tank heads for rolling-horizon runs
+  if (!config.fn_tank_heads.empty()) read_tank_heads(config.fn_tank_heads);
+
   best_cost_global = std::numeric_limits<double>::max();
   best_cost_local = std::numeric_limits<double>::max();
+  lower_bound_local = 0.0;
+  lower_bound_global = 0.0;
   request_nonblocking = MPI_REQUEST_NULL;
+
+  // Keep the non-blocking reductions apart from the blocking collectives on MPI_COMM_WORLD
+  MPI_Comm_dup(MPI_COMM_WORLD, &comm_sync);
 }
 
 void BBConstraints::sync_best()
@@ -41,17 +59,43 @@ void BBConstraints::sync_best()
   int err, flag;
 
   if (request_nonblocking == MPI_REQUEST_NULL)
-    MPI_Iallreduce(&best_cost_local, &best_cost_global, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD, &request_nonblocking);
+  {
+    sync_send[0] = best_cost_local;
+    sync_send[1] = lower_bound_local;
+    MPI_Iallreduce(sync_send, sync_recv, 2, MPI_DOUBLE, MPI_MIN, comm_sync, &request_nonblocking);
+  }
 
   // MPI_Test will update the request_nonblocking when the allreduce is complete
   err = MPI_Test(&request_nonblocking, &flag, MPI_STATUS_IGNORE);
   if (err != MPI_SUCCESS) throw std::runtime_error("BBConstraints::sync_best: MPI_Test failed");
+  if (flag)
+  {
+    best_cost_global = sync_recv[0];
+    lower_bound_global = sync_recv[1];
+  }
+}
+
+void BBConstraints::sync_best_final()
+{
+  double send[2] = {best_cost_local, lower_bound_local};
+  double recv[2];
+  MPI_Allreduce(send, recv, 2, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  best_cost_global = recv[0];
+  lower_bound_global = recv[1];
+}
+
+double BBConstraints::gap() const
+{
+  double ub = std::min(best_cost_local, best_cost_global);
+  if (ub == std::numeric_limits<double>::max()) return 1.0;
+  double lb = std::min(lower_bound_global, ub);
+  return ub > 0.0 ? (ub - lb) / ub : 0.0;
 }
 
 // Destructor
 BBConstraints::~BBConstraints()
 {
-  // Clean up resources if necessary
+  // Pending requests cannot be cancelled portably, so the communicator is left to MPI_Finalize
 }
 
 void BBConstraints::update_best(double cost, std::vector<int> x, std::vector<int> y)
@@ -93,6 +137,7 @@ void BBConstraints::get_network_elements_indices(std::string inpFile)
 {
   Project p;
   CHK(p.load(inpFile.c_str()), "BBConstraints::get_network_elements_indices: Load project");
+  reduce_network(p);
 
   Network *nw = p.getNetwork();
 
@@ -118,6 +163,95 @@ void BBConstraints::get_network_elements_indices(std::string inpFile)
   }
 }
 
+void BBConstraints::load_project(Project &p) const
+{
+  CHK(p.load(inpFile.c_str()), "BBConstraints::load_project: Load project");
+  p.shareSymbolicFactor(symbolic_factor);
+  p.shareDemandTable(demand_table);
+  reduce_network(p);
+
+  Network *nw = p.getNetwork();
+  nw->options.setOption(Options::TimeOption::TOTAL_DURATION, 3600 * h_max);
+
+  // Rolling horizon: patterns (demands, prices) and clock time start shift hours later
+  if (shift > 0)
+  {
+    nw->options.setOption(Options::TimeOption::PATTERN_START, (int)nw->option(Options::TimeOption::PATTERN_START) + 3600 * shift);
+    nw->options.setOption(Options::TimeOption::START_TIME, (int)(nw->option(Options::TimeOption::START_TIME) + 3600 * shift) % 86400);
+  }
+
+  // Rolling horizon: measured heads are the initial state of the tanks
+  for (const auto &[tank_name, head] : tank_heads)
+  {
+    Tank *tank = (Tank *)nw->node(tanks.at(tank_name));
+    tank->initHead = head / nw->ucf(Units::LENGTH);
+  }
+}
+
+Project *BBConstraints::acquire_project()
+{
+  ProfileScope scope("acquire_project");
+
+  std::unique_ptr<Project> p;
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!idle_projects.empty())
+    {
+      p = std::move(idle_projects.back());
+      idle_projects.pop_back();
+    }
+  }
+
+  // A new project records the state it is reset to when reused, a reused one undoes the changes of its last task
+  if (!p)
+  {
+    p = std::make_unique<Project>();
+    load_project(*p);
+    CHK(p->initSolver(EN_INITFLOW), "BBConstraints::acquire_project: Initialize solver");
+    CHK(p->saveLoadedState(), "BBConstraints::acquire_project: Save loaded state");
+  }
+  else
+  {
+    CHK(p->reset(), "BBConstraints::acquire_project: Reset project");
+  }
+  return p.release();
+}
+
+void BBConstraints::release_project(Project *p)
+{
+  std::unique_ptr<Project> project(p);
+  std::lock_guard<std::mutex> lock(pool_mutex);
+  if (idle_projects.size() < max_idle_projects) idle_projects.push_back(std::move(project));
+}
+
+void BBConstraints::reduce_network(Project &p) const
+{
+  if (!skeletonize) return;
+
+  std::set<std::string> keep_nodes, keep_links;
+  for (const auto &node : nodes)
+    keep_nodes.insert(node.first);
+  for (const auto &tank : tanks)
+    keep_nodes.insert(tank.first);
+  for (const auto &pump : pumps)
+    keep_links.insert(pump.first);
+  CHK(p.skeletonize(keep_nodes, keep_links), "BBConstraints::reduce_network: Skeletonize project");
+}
+
+void BBConstraints::read_tank_heads(const std::string &fn)
+{
+  std::ifstream f(fn);
+  if (!f.is_open()) throw std::runtime_error("BBConstraints::read_tank_heads: cannot open " + fn);
+
+  nlohmann::json j;
+  f >> j;
+  for (const auto &[tank_name, head] : j.items())
+  {
+    if (tanks.find(tank_name) == tanks.end()) throw std::runtime_error("BBConstraints::read_tank_heads: unknown tank " + tank_name);
+    tank_heads[tank_name] = head.get<double>();
+  }
+}
+
 // Function to display pressure status
 void BBConstraints::show_pressures(bool is_feasible, const std::string &node_name, double pressure, double threshold)
 {
@@ -336,7 +470,7 @@ void BBConstraints::update_pumps(Project &p, const int h, const std::vector<int>
       // Retrieve new speed factor
       double factor_new = static_cast<double>(xi[j++]);
       // Retrieve old speed factor
-      const int factor_id = i - 1; // pattern index is 0-based
+      const int factor_id = (i - 1 + shift) % pattern->size(); // pattern index is 0-based
       // Update speed factor
       pattern->setFactor(factor_id, factor_new);
     }
@@ -367,6 +501,10 @@ void BBConstraints::to_json(char *fn) const
   j["best_cost"] = best_cost_local;
   j["best_x"] = best_x;
   j["best_y"] = best_y;
+  j["best_cost_global"] = best_cost_global;
+  j["lower_bound"] = std::min(lower_bound_global, best_cost_global);
+  j["gap"] = gap();
+  j["shift"] = shift;
   std::ofstream f(fn);
   f << j.dump(2);
 }
@@ -10,7 +10,9 @@
 #include "epanet3.h"
 
 #include <map>
+#include <memory>
 #include <mpi.h>
+#include <mutex>
 #include <queue>
 #include <string>
 
@@ -38,15 +40,36 @@ public:
   std::string inpFile;              ///< Path to input file
   double best_cost_local;           ///< Local best cost
   double best_cost_global;          ///< Global best cost
+  double lower_bound_local;         ///< Lower bound of the open nodes of this process
+  double lower_bound_global;        ///< Lower bound of the open nodes of all processes
   std::vector<int> best_x;          ///< Best pump statuses
   std::vector<int> best_y;          ///< Best pump speed patterns
+  int h_max;                        ///< Scheduling horizon (hours)
+  int shift;                        ///< Hours between the patterns start and the schedule start
+  bool skeletonize;                 ///< Reduce the network before simulating it
+  /// Measured initial tank heads (empty to use the input file)
+  std::map<std::string, double> tank_heads;
   MPI_Request request_nonblocking;
+  MPI_Comm comm_sync;     ///< Communicator reserved for the non-blocking sync_best
+  double sync_send[2];    ///< {best_cost_local, lower_bound_local} being reduced
+  double sync_recv[2];    ///< {best_cost_global, lower_bound_global} being reduced
 
   /**
-   * @brief Synchronizes the best solution found among all processes
+   * @brief Synchronizes the best solution and the open-node lower bound among all processes (non-blocking)
    */
   void sync_best();
 
+  /**
+   * @brief Blocking version of sync_best, used once the search has stopped
+   */
+  void sync_best_final();
+
+  /**
+   * @brief Relative gap between the incumbent and the global lower bound
+   * @return (ub - lb) / ub, or 1 if no incumbent is known
+   */
+  double gap() const;
+
   /**
    * @brief Constructs constraints checker for the given input file
    * @param inpFile Path to the EPANET input file
@@ -92,6 +115,50 @@ public:
    */
   BBPruneReason check_feasibility(Project &p, const int h, double &cost, bool verbose);
 
+  /**
+   * @brief Loads the input file and prepares it for the scheduling horizon
+   *
+   * Sets the simulation duration to h_max hours, offsets all time patterns
+   * by the rolling-horizon shift and replaces the initial tank heads by the
+   * measured ones, if any.
+   * @param p Project to be loaded
+   */
+  void load_project(Project &p) const;
+
+  /**
+   * @brief Takes a loaded and initialized project, ready to be simulated from time 0
+   *
+   * Projects given back with release_project are kept loaded and reused:
+   * Project::reset returns them to the state they were loaded and
+   * initialized with, so that the network is neither parsed nor allocated
+   * again for each task.
+   * @return Project to be given back with release_project
+   */
+  Project *acquire_project();
+
+  /**
+   * @brief Gives back a project taken with acquire_project for reuse
+   *
+   * At most max_idle_projects are kept, any other is deleted.
+   * @param p Project no longer in use
+   */
+  void release_project(Project *p);
+
+  /**
+   * @brief Skeletonizes a freshly loaded project, if enabled
+   *
+   * The constrained nodes, the tanks and the pumps are kept, so that their
+   * indices are the same in every project reduced this way.
+   * @param p Project to be reduced
+   */
+  void reduce_network(Project &p) const;
+
+  /**
+   * @brief Reads measured tank heads from a JSON file ({"tank name": head, ...})
+   * @param fn Path to the JSON file
+   */
+  void read_tank_heads(const std::string &fn);
+
   /**
    * @brief Loads node and tank IDs from input file
    * @param inpFile Path to the EPANET input file
@@ -174,6 +241,12 @@ public:
   void to_json(char *fn) const;
 
 private:
+  static constexpr size_t max_idle_projects = 4;      ///< Idle projects kept for reuse
+  std::vector<std::unique_ptr<Project>> idle_projects; ///< Loaded projects not in use
+  std::mutex pool_mutex;                              ///< Guards the idle projects
+  std::shared_ptr<SymbolicFactor> symbolic_factor;    ///< Symbolic factorization shared by all projects
+  std::shared_ptr<DemandTableCache> demand_table;     ///< Demand table shared by all projects
+
   /**
    * @brief Helper to display pressure constraint status
    * @param is_feasible Whether constraint is satisfied
@@ -202,3 +275,23 @@ private:
    */
   void show_stability(bool is_feasible, const std::string &tank_name, double level, double initial_level);
 };
+
+/**
+ * @brief Holds a project taken from BBConstraints::acquire_project until it goes out of scope
+ */
+class BBProjectLease
+{
+public:
+  explicit BBProjectLease(BBConstraints &constraintsRef) : constraints(constraintsRef), p(constraintsRef.acquire_project()) {}
+  ~BBProjectLease() { constraints.release_project(p); }
+  BBProjectLease(const BBProjectLease &) = delete;
+  BBProjectLease &operator=(const BBProjectLease &) = delete;
+
+  Project &operator*() const { return *p; }
+  Project *operator->() const { return p; }
+  Project *get() const { return p; }
+
+private:
+  BBConstraints &constraints;
+  Project *p;
+};
@@ -0,0 +1,402 @@
+// src/CLI/BBHeuristics.h
+#pragma once
+
+#include "BBConfig.h"
+#include "BBConstraints.h"
+#include "BBSolver.h"
+#include "Console.h"
+#include "Profiler.h"
+
+#include "Core/project.h"
+#include "Elements/pattern.h"
+#include "Elements/pump.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mpi.h>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+//---------------------------------------------------------------------
+// BBHeuristics: Builds a feasible incumbent before branch-and-bound starts.
+//
+// Candidate schedules come from the pump speed patterns of the input file,
+// from a greedy tariff-aware filling of the horizon and from a randomized
+// local search over x. Every candidate is simulated for the full horizon
+// and checked against the same constraints used by BBSolver. The best
+// schedule found on any rank is broadcast and seeds BBConstraints.
+// In rolling-horizon runs the previous plan, shifted to the current
+// window, is tried first.
+//---------------------------------------------------------------------
+class BBHeuristics
+{
+public:
+  BBHeuristics(const BBConfig &configRef, BBConstraints &constraintsRef) : config(configRef), constraints(constraintsRef)
+  {
+    num_pumps = constraints.get_num_pumps();
+  }
+
+  /**
+   * @brief Runs all heuristics and seeds the incumbent on every rank
+   * @return Cost of the incumbent (max() if no feasible schedule was found)
+   */
+  double run()
+  {
+    ProfileScope scope("heuristics");
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    load_patterns_and_prices();
+
+    // Rolling horizon: the previous plan, shifted, is the first candidate
+    std::vector<int> x;
+    if (!config.fn_prev_best.empty() && schedule_from_previous(x)) try_schedule(x, "previous plan");
+    if (!config.use_heuristics)
+    {
+      broadcast_best();
+      return constraints.best_cost_global;
+    }
+
+    // Deterministic candidates are cheap and identical on every rank
+    if (schedule_from_patterns(x)) try_schedule(x, "patterns");
+
+    // The greedy candidates are independent and are simulated side by side
+    std::vector<std::vector<int>> greedy;
+    for (int base = 0; base <= num_pumps; ++base)
+    {
+      for (double threshold : price_levels)
+      {
+        if (schedule_from_tariff(base, threshold, x)) greedy.push_back(x);
+      }
+    }
+    std::vector<double> costs = evaluate_batch(greedy);
+    for (size_t i = 0; i < greedy.size(); ++i) accept_schedule(greedy[i], costs[i], "greedy");
+
+    // Each rank explores a different random neighbourhood
+    local_search(rank);
+
+    broadcast_best();
+
+    if (rank == 0)
+    {
+      Console::printf(Console::Color::BRIGHT_YELLOW, "Heuristics: evaluated %d schedules, incumbent cost=%s\n", num_evals,
+                      constraints.fmt_cost(constraints.best_cost_global).c_str());
+    }
+    return constraints.best_cost_global;
+  }
+
+private:
+  const BBConfig &config;
+  BBConstraints &constraints;
+  int num_pumps;
+  int num_evals = 0;
+  std::vector<double> prices;       // energy price at each hour [1, h_max]
+  std::vector<double> price_levels; // distinct prices in increasing order
+  std::vector<int> x_patterns;      // pump statuses given by the input file patterns
+
+  //===============================================================
+  // Reads the pump speed patterns and the energy price pattern
+  //===============================================================
+  void load_patterns_and_prices()
+  {
+    Project p;
+    CHK(p.load(config.inpFile.c_str()), "BBHeuristics: Load project");
+    constraints.reduce_network(p);
+    Network *nw = p.getNetwork();
+
+    prices.assign(config.h_max + 1, 1.0);
+    x_patterns.assign((config.h_max + 1) * num_pumps, 0);
+
+    int j = 0;
+    for (const auto &pump : constraints.pumps)
+    {
+      Pump *pump_link = (Pump *)nw->link(pump.second);
+      Pattern *speed = pump_link->speedPattern;
+      for (int h = 1; h <= config.h_max; ++h)
+      {
+        if (speed && speed->size() > 0) x_patterns[h * num_pumps + j] = speed->factor((h - 1 + config.shift) % speed->size()) > 0 ? 1 : 0;
+      }
+
+      // All pumps in the schedule share the tariff, so the first one is enough
+      if (j == 0)
+      {
+        Pattern *cost = pump_link->costPattern;
+        for (int h = 1; h <= config.h_max; ++h)
+        {
+          prices[h] = pump_link->costPerKwh;
+          if (cost && cost->size() > 0) prices[h] *= cost->factor((h - 1 + config.shift) % cost->size());
+        }
+      }
+      ++j;
+    }
+
+    std::set<double> levels(prices.begin() + 1, prices.end());
+    price_levels.assign(levels.begin(), levels.end());
+  }
+
+  //===============================================================
+  // Counts the actuations of x and checks them against max_actuations
+  //===============================================================
+  bool check_actuations(const std::vector<int> &x) const
+  {
+    std::vector<int> allowed_01(num_pumps, config.max_actuations);
+    std::vector<int> allowed_10(num_pumps, config.max_actuations);
+    BBPumpController::computeAllowedSwitches(num_pumps, &x[0], config.h_max + 1, allowed_01, allowed_10);
+    for (int pump_id = 0; pump_id < num_pumps; ++pump_id)
+    {
+      if (allowed_01[pump_id] < 0 || allowed_10[pump_id] < 0) return false;
+    }
+    return true;
+  }
+
+  //===============================================================
+  // Converts a y vector into x using the same rules as BBSolver::updateX
+  //===============================================================
+  bool y_to_x(const std::vector<int> &y, std::vector<int> &x) const
+  {
+    x.assign((config.h_max + 1) * num_pumps, 0);
+    std::vector<int> pumps_sorted(num_pumps);
+    for (int h = 1; h <= config.h_max; ++h)
+    {
+      const int *x_old = &x[num_pumps * (h - 1)];
+      int *x_new = &x[num_pumps * h];
+      std::copy(x_old, x_old + num_pumps, x_new);
+      if (y[h] == y[h - 1]) continue;
+
+      std::vector<int> allowed_01(num_pumps, config.max_actuations);
+      std::vector<int> allowed_10(num_pumps, config.max_actuations);
+      BBPumpController::computeAllowedSwitches(num_pumps, &x[0], h, allowed_01, allowed_10);
+      std::iota(pumps_sorted.begin(), pumps_sorted.end(), 0);
+
+      bool success;
+      if (y[h] > y[h - 1])
+      {
+        int counter_01 = y[h] - y[h - 1];
+        BBPumpController::sortPumps(pumps_sorted, allowed_01, allowed_10, true);
+        success = BBPumpController::switchPumpsOn(x_new, pumps_sorted, allowed_01, counter_01);
+      }
+      else
+      {
+        int counter_10 = y[h - 1] - y[h];
+        BBPumpController::sortPumps(pumps_sorted, allowed_01, allowed_10, false);
+        success = BBPumpController::switchPumpsOff(x_new, pumps_sorted, allowed_10, counter_10);
+      }
+      if (!success) return false;
+    }
+    return true;
+  }
+
+  bool schedule_from_patterns(std::vector<int> &x) const
+  {
+    x = x_patterns;
+    return check_actuations(x);
+  }
+
+  //===============================================================
+  // Shifts the schedule of a previous run to the current window
+  // (hours beyond its horizon wrap around, as the patterns do)
+  //===============================================================
+  bool schedule_from_previous(std::vector<int> &x) const
+  {
+    std::ifstream f(config.fn_prev_best);
+    if (!f.is_open()) throw std::runtime_error("BBHeuristics: cannot open " + config.fn_prev_best);
+    nlohmann::json j;
+    f >> j;
+
+    std::vector<int> x_prev = j.at("best_x").get<std::vector<int>>();
+    int shift_prev = j.value("shift", 0);
+    int h_prev = (int)x_prev.size() / num_pumps - 1;
+    if (h_prev < 1) return false;
+
+    int delta = config.shift - shift_prev;
+    x.assign((config.h_max + 1) * num_pumps, 0);
+    for (int h = 1; h <= config.h_max; ++h)
+    {
+      int h_old = ((h - 1 + delta) % h_prev + h_prev) % h_prev + 1;
+      std::copy(&x_prev[h_old * num_pumps], &x_prev[h_old * num_pumps] + num_pumps, &x[h * num_pumps]);
+    }
+    return check_actuations(x);
+  }
+
+  //===============================================================
+  // Greedy tariff-aware filling: one extra pump in the cheap hours
+  //===============================================================
+  bool schedule_from_tariff(int base, double threshold, std::vector<int> &x) const
+  {
+    std::vector<int> y(config.h_max + 1, 0);
+    for (int h = 1; h <= config.h_max; ++h)
+    {
+      y[h] = base + (prices[h] <= threshold ? 1 : 0);
+      y[h] = std::min(y[h], num_pumps);
+    }
+    return y_to_x(y, x);
+  }
+
+  //===============================================================
+  // Simulates the full horizon and returns the cost of x
+  // (max() if any constraint is violated or the incumbent is not improved)
+  //===============================================================
+  double evaluate(const std::vector<int> &x)
+  {
+    ProfileScope scope("heuristics_evaluate");
+    ++num_evals;
+
+    BBProjectLease lease(constraints);
+    Project &p = *lease;
+    constraints.update_pumps(p, config.h_max, x, false);
+
+    double cost = std::numeric_limits<double>::max();
+    int t = 0, dt = 0;
+    do
+    {
+      CHK(p.runSolver(&t), "Run solver");
+      CHK(p.advanceSolver(&dt), "Advance solver");
+      if (constraints.check_feasibility(p, t / 3600, cost, false) != BBPruneReason::NONE) return std::numeric_limits<double>::max();
+    } while (dt > 0);
+
+    if (constraints.check_stability(p, false) != BBPruneReason::NONE) return std::numeric_limits<double>::max();
+    return cost;
+  }
+
+  //===============================================================
+  // Simulates several schedules at once (their hydraulic solutions run in
+  // lockstep) and returns the cost of each, as evaluate() would
+  //===============================================================
+  std::vector<double> evaluate_batch(const std::vector<std::vector<int>> &xs)
+  {
+    ProfileScope scope("heuristics_evaluate");
+    num_evals += (int)xs.size();
+
+    size_t n = xs.size();
+    std::vector<std::unique_ptr<BBProjectLease>> projects(n);
+    std::vector<double> running(n, std::numeric_limits<double>::max());
+    std::vector<double> costs(n, std::numeric_limits<double>::max());
+    std::vector<size_t> active, next;
+    for (size_t i = 0; i < n; ++i)
+    {
+      projects[i] = std::make_unique<BBProjectLease>(constraints);
+      constraints.update_pumps(**projects[i], config.h_max, xs[i], false);
+      active.push_back(i);
+    }
+
+    std::vector<Project *> lanes;
+    std::vector<int> t, codes;
+    while (!active.empty())
+    {
+      lanes.clear();
+      for (size_t i : active) lanes.push_back(projects[i]->get());
+      Project::runSolverLanes(lanes, t, codes);
+
+      next.clear();
+      for (size_t k = 0; k < active.size(); ++k)
+      {
+        size_t i = active[k];
+        Project &p = **projects[i];
+        int dt = 0;
+        CHK(codes[k], "Run solver");
+        CHK(p.advanceSolver(&dt), "Advance solver");
+        if (constraints.check_feasibility(p, t[k] / 3600, running[i], false) != BBPruneReason::NONE) continue;
+        if (dt > 0)
+        {
+          next.push_back(i);
+          continue;
+        }
+        if (constraints.check_stability(p, false) == BBPruneReason::NONE) costs[i] = running[i];
+      }
+      active.swap(next);
+    }
+    return costs;
+  }
+
+  bool try_schedule(const std::vector<int> &x, const char *label) { return accept_schedule(x, evaluate(x), label); }
+
+  bool accept_schedule(const std::vector<int> &x, double cost, const char *label)
+  {
+    if (cost >= constraints.best_cost_local) return false;
+
+    std::vector<int> y(config.h_max + 1, 0);
+    for (int h = 1; h <= config.h_max; ++h)
+      y[h] = std::accumulate(x.begin() + h * num_pumps, x.begin() + (h + 1) * num_pumps, 0);
+    constraints.update_best(cost, x, y);
+
+    if (config.verbose) Console::printf(Console::Color::BRIGHT_GREEN, "Heuristics: %s schedule, cost=%.2f\n", label, cost);
+    return true;
+  }
+
+  //===============================================================
+  // Randomized first-improvement local search over x
+  //===============================================================
+  void local_search(int rank)
+  {
+    if (config.heuristic_iters <= 0 || constraints.best_x.empty()) return;
+
+    std::default_random_engine rng(12345 + rank);
+    std::uniform_int_distribution<int> pick_pump(0, num_pumps - 1);
+    std::uniform_int_distribution<int> pick_hour(1, config.h_max);
+    std::uniform_int_distribution<int> pick_move(0, 2);
+
+    std::vector<int> x;
+    for (int iter = 0; iter < config.heuristic_iters; ++iter)
+    {
+      x = constraints.best_x;
+      int pump_id = pick_pump(rng);
+      int h1 = pick_hour(rng);
+      int h2 = pick_hour(rng);
+      if (h1 > h2) std::swap(h1, h2);
+
+      switch (pick_move(rng))
+      {
+      case 0: // flip a single hour
+        x[h1 * num_pumps + pump_id] = 1 - x[h1 * num_pumps + pump_id];
+        break;
+      case 1: // switch the pump off in [h1, h2]
+        for (int h = h1; h <= h2; ++h)
+          x[h * num_pumps + pump_id] = 0;
+        break;
+      default: // switch the pump on in [h1, h2]
+        for (int h = h1; h <= h2; ++h)
+          x[h * num_pumps + pump_id] = 1;
+        break;
+      }
+
+      if (x == constraints.best_x || !check_actuations(x)) continue;
+      try_schedule(x, "local search");
+    }
+  }
+
+  //===============================================================
+  // Shares the best schedule among all ranks
+  //===============================================================
+  void broadcast_best()
+  {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    struct
+    {
+      double cost;
+      int rank;
+    } local = {constraints.best_cost_local, rank}, global;
+    MPI_Allreduce(&local, &global, 1, MPI_DOUBLE_INT, MPI_MINLOC, MPI_COMM_WORLD);
+    if (global.cost == std::numeric_limits<double>::max()) return;
+
+    std::vector<int> x((config.h_max + 1) * num_pumps, 0);
+    std::vector<int> y(config.h_max + 1, 0);
+    if (rank == global.rank)
+    {
+      x = constraints.best_x;
+      y = constraints.best_y;
+    }
+    MPI_Bcast(x.data(), (int)x.size(), MPI_INT, global.rank, MPI_COMM_WORLD);
+    MPI_Bcast(y.data(), (int)y.size(), MPI_INT, global.rank, MPI_COMM_WORLD);
+
+    constraints.best_cost_local = std::numeric_limits<double>::max();
+    constraints.update_best(global.cost, x, y);
+    constraints.best_cost_global = global.cost;
+  }
+};
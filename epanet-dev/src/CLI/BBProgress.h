@@ -0,0 +1,88 @@
+// src/CLI/BBProgress.h
+#pragma once
+
+#include "BBConfig.h"
+#include "BBConstraints.h"
+#include "BBStatistics.h"
+#include "Console.h"
+
+#include <chrono>
+#include <limits>
+#include <mpi.h>
+#include <string>
+
+//---------------------------------------------------------------------
+// BBProgress: Enforces the search budgets and reports the optimality gap.
+//
+// The search stops when the wall-clock or node budget of the rank is
+// exhausted, or when the relative gap between the incumbent and the
+// lower bound of the open nodes of all ranks reaches gap_target.
+//---------------------------------------------------------------------
+class BBProgress
+{
+public:
+  double pending_lb = 0.0; // lower bound of the tasks of this rank not yet started
+
+  BBProgress(const BBConfig &configRef) : config(configRef)
+  {
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    start();
+  }
+
+  void start()
+  {
+    tic = std::chrono::high_resolution_clock::now();
+    last_report = 0.0;
+  }
+
+  double elapsed() const
+  {
+    auto toc = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count() / 1e6;
+  }
+
+  /**
+   * @brief Checks the budgets and the gap target
+   * @return true if the search must stop (the reason is saved in stats)
+   */
+  bool stop_requested(const BBConstraints &constraints, BBStatistics &stats)
+  {
+    if (!stats.stop_reason.empty()) return true;
+
+    if (config.time_budget > 0 && elapsed() >= config.time_budget)
+      stats.stop_reason = "TIME_BUDGET";
+    else if (config.node_budget > 0 && stats.num_nodes() >= config.node_budget)
+      stats.stop_reason = "NODE_BUDGET";
+    else if (config.gap_target > 0 && constraints.gap() <= config.gap_target)
+      stats.stop_reason = "GAP";
+
+    if (!stats.stop_reason.empty())
+    {
+      Console::printf(Console::Color::BRIGHT_YELLOW, "Proc %02d stopping: %s after %.3f seconds\n", rank, stats.stop_reason.c_str(), elapsed());
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Prints the incumbent, the global lower bound and the gap (rank 0, every report_interval seconds)
+   */
+  void report(const BBConstraints &constraints, const BBStatistics &stats, bool force = false)
+  {
+    if (rank != 0) return;
+    double t = elapsed();
+    if (!force && t - last_report < config.report_interval) return;
+    last_report = t;
+
+    double ub = std::min(constraints.best_cost_local, constraints.best_cost_global);
+    double lb = std::min(constraints.lower_bound_global, ub);
+    Console::printf(Console::Color::BRIGHT_CYAN, "⏱ t=%.1fs nodes=%ld incumbent=%s lower_bound=%s gap=%.2f%%\n", t, stats.num_nodes(),
+                    constraints.fmt_cost(ub).c_str(), constraints.fmt_cost(lb).c_str(), 100.0 * constraints.gap());
+  }
+
+private:
+  const BBConfig &config;
+  int rank;
+  std::chrono::high_resolution_clock::time_point tic;
+  double last_report;
+};
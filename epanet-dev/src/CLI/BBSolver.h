@@ -1,8 +1,10 @@
 // BBSolver.h
 #pragma once
 
+#include "BBCheckpoint.h"
 #include "BBConfig.h"
 #include "BBConstraints.h"
+#include "BBProgress.h"
 #include "BBStatistics.h"
 #include "Console.h"
 #include "Profiler.h"
@@ -12,6 +14,7 @@
 #include "Elements/tank.h"
 
 #include <algorithm>
+#include <limits>
 #include <queue>
 #include <stdexcept>
 #include <vector>
@@ -27,8 +30,11 @@ class BBTask
 {
 public:
   int uid;
-  int h_root; // first hour that can be changed
+  int h_root;      // first hour that can be changed
+  int y_first = 0; // first value of y[h_root] to be explored
   double cost;
+  double cost_lb = 0.0;      // lower bound on the cost of any schedule in this task
+  std::vector<double> costs; // cost at the end of each hour of the current branch
   std::vector<ProjectData> snapshots;
   std::vector<int> y;
   std::vector<int> x;
@@ -171,19 +177,40 @@ class BBSolver
 {
 public:
   // Constructor can take config and constraints references
-  BBSolver(BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef)
-      : config(configRef), constraints(constraintsRef), stats(statsRef)
+  BBSolver(BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef, BBProgress &progressRef, BBCheckpoint &checkpointRef)
+      : config(configRef), constraints(constraintsRef), stats(statsRef), progress(progressRef), checkpoint(checkpointRef)
   {
   }
 
+  // Lower bound of the open nodes of a task: siblings left at hour h share the cost of their parent at h-1
+  double lowerBound(const BBTask &task) const
+  {
+    double lb = std::numeric_limits<double>::max();
+    for (int h = task.h_root; h <= std::min(task.h, config.h_max); ++h)
+    {
+      if (task.y[h] < task.num_pumps) lb = std::min(lb, task.costs[h - 1]);
+    }
+    if (task.is_feasible && task.h < config.h_max) lb = std::min(lb, task.costs[task.h]);
+    return lb;
+  }
+
+  // Simulates the fixed prefix y[1, h_root - 1] only; its cost becomes the lower bound of the task
+  BBPruneReason screenTask(BBTask &task)
+  {
+    BBProjectLease p(constraints);
+    initTask(task, *p);
+    BBPruneReason prune_reason = initSnapshots(task);
+    if (prune_reason == BBPruneReason::NONE) task.cost_lb = task.cost;
+    task.snapshots.clear();
+    task.p = nullptr;
+    return prune_reason;
+  }
+
   // Orchestrates the BBTask solution process
   void solveTask(BBTask &task)
   {
-    Project p;
-    task.p = &p;
-    task.cost = std::numeric_limits<double>::max();
-    task.x.resize((config.h_max + 1) * task.num_pumps, 0);
-    task.is_feasible = true;
+    BBProjectLease p(constraints);
+    initTask(task, *p);
 
     // initialize snapshots
     BBPruneReason prune_reason = initSnapshots(task);
@@ -219,6 +246,13 @@ public:
       stats.add_stats(processLevel(task), task.h);
 
       if (config.verbose) stats.show();
+
+      // Share the incumbent and the frontier bound, then check the budgets
+      constraints.lower_bound_local = std::min(progress.pending_lb, lowerBound(task));
+      constraints.sync_best();
+      progress.report(constraints, stats);
+      checkpoint.save_if_due();
+      if (progress.stop_requested(constraints, stats)) break;
     }
   }
 
@@ -227,9 +261,20 @@ private:
   BBConfig &config;
   BBConstraints &constraints;
   BBStatistics &stats;
+  BBProgress &progress;
+  BBCheckpoint &checkpoint;
   //---------------------------------------------------------------------
-  // Helper function for tasks initialization
+  // Helper functions for tasks initialization
   //---------------------------------------------------------------------
+  inline void initTask(BBTask &task, Project &p)
+  {
+    task.p = &p;
+    task.cost = std::numeric_limits<double>::max();
+    task.x.assign((config.h_max + 1) * task.num_pumps, 0);
+    task.costs.assign(config.h_max + 1, 0.0);
+    task.is_feasible = true;
+  }
+
   inline BBPruneReason initSnapshots(BBTask &task)
   {
     if (config.verbose)
@@ -238,13 +283,9 @@ private:
       Console::printf(Console::Color::BRIGHT_YELLOW, "TID[%d]: initSnapshots: task.h_root=%d\n", task.tid, task.h_root);
     }
 
-    // load project
+    // project loaded and initialized by acquire_project
     Project &p = *(task.p);
-    p.load(config.inpFile.c_str());
-    Network *nw = p.getNetwork();
     int t_max = 3600 * config.h_max;
-    nw->options.setOption(Options::TimeOption::TOTAL_DURATION, t_max);
-    p.initSolver(EN_INITFLOW);
 
     // Initialize pumps
     for (int i = 1; i < task.h_root; ++i)
@@ -290,6 +331,7 @@ private:
       if (t_new % 3600 == 0)
       {
         task.h = t_new / 3600; // update hour
+        task.costs[task.h] = task.cost;
         p.copy_to(task.snapshots[task.h]);
       }
     } while (task.h < (task.h_root - 1)); // initialize the snapshots for hours up to h_root
@@ -310,7 +352,8 @@ private:
       // If not the last level, move to the next
       if (task.h < config.h_max)
       {
-        task.y[++task.h] = 0;
+        ++task.h;
+        task.y[task.h] = (task.h == task.h_root) ? task.y_first : 0;
         task.is_feasible = true;
         return;
       }
@@ -433,7 +476,11 @@ private:
     BBPruneReason prune_reason = epanetSolve(task);
 
     // copy current state to snapshot
-    if (task.is_feasible) task.p->copy_to(task.snapshots[task.h]);
+    if (task.is_feasible)
+    {
+      task.costs[task.h] = task.cost;
+      task.p->copy_to(task.snapshots[task.h]);
+    }
 
     return prune_reason;
   }
@@ -525,9 +572,10 @@ private:
   }
 };
 
-void processTask(BBTask &task, BBConfig &config, BBConstraints &constraints, BBStatistics &stats)
+inline void processTask(BBTask &task, BBConfig &config, BBConstraints &constraints, BBStatistics &stats, BBProgress &progress,
+                        BBCheckpoint &checkpoint)
 {
   ProfileScope scope("processTask");
-  BBSolver solver(config, constraints, stats);
+  BBSolver solver(config, constraints, stats, progress, checkpoint);
   solver.solveTask(task);
 }
@@ -0,0 +1,207 @@
+// src/CLI/BBSplitter.h
+#pragma once
+
+#include "BBCheckpoint.h"
+#include "BBConfig.h"
+#include "BBConstraints.h"
+#include "BBProgress.h"
+#include "BBSolver.h"
+#include "BBStatistics.h"
+#include "Console.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mpi.h>
+#include <vector>
+
+//---------------------------------------------------------------------
+// BBSplitter: Generates balanced and viable tasks from the top of the tree.
+//
+// The prefixes y[1, d] are expanded breadth-first, largest estimated
+// subtree first, until there are tasks_per_rank tasks per rank or the
+// split depth reaches level. Every new prefix is simulated once (the
+// evaluations are spread over the ranks) and the infeasible ones are
+// discarded together with their subtrees. The size of a subtree rooted at
+// depth d is estimated from the fraction of feasible children seen at each
+// depth; tasks are then assigned to the ranks by decreasing size, each one
+// to the least loaded rank.
+//---------------------------------------------------------------------
+class BBSplitter
+{
+public:
+  BBSplitter(BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef, BBProgress &progressRef, BBCheckpoint &checkpointRef)
+      : config(configRef), constraints(constraintsRef), stats(statsRef), progress(progressRef), checkpoint(checkpointRef)
+  {
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+    num_pumps = constraints.get_num_pumps();
+    max_depth = std::max(1, std::min(config.h_max - 2, config.level));
+    num_evaluated.assign(config.h_max + 1, 0);
+    num_feasible.assign(config.h_max + 1, 0);
+  }
+
+  void run(std::vector<BBTask> &tasks)
+  {
+    ProfileScope scope("splitter");
+
+    std::vector<Prefix> frontier(1);
+    frontier[0].y.assign(config.h_max + 1, 0);
+    size_t target = (size_t)config.tasks_per_rank * num_procs;
+
+    // The root itself is never a task (h_root must be at least 2)
+    while (frontier.size() < target || frontier[0].depth == 0)
+    {
+      // Largest subtrees first; at equal depth the cheapest prefix has the least cost pruning ahead
+      std::stable_sort(frontier.begin(), frontier.end(), [this](const Prefix &a, const Prefix &b) { return is_larger(a, b); });
+
+      // Expand a batch of prefixes so that every rank gets some work, without overshooting the target
+      size_t batch = std::max(1, num_procs / (num_pumps + 1));
+      if (frontier.size() < target) batch = std::min(batch, (target - frontier.size()) / num_pumps + 1);
+      std::vector<Prefix> parents, others;
+      for (Prefix &prefix : frontier)
+      {
+        bool expand = prefix.depth < max_depth && parents.size() < batch;
+        (expand ? parents : others).push_back(std::move(prefix));
+      }
+      frontier = std::move(others);
+      if (parents.empty()) break;
+
+      std::vector<Prefix> children = expand(parents);
+      frontier.insert(frontier.end(), children.begin(), children.end());
+      if (frontier.empty()) break;
+    }
+
+    emit(frontier, tasks);
+  }
+
+private:
+  struct Prefix
+  {
+    std::vector<int> y;
+    int depth = 0;
+    double cost = 0.0; // cost at the end of hour depth
+  };
+
+  BBConfig &config;
+  BBConstraints &constraints;
+  BBStatistics &stats;
+  BBProgress &progress;
+  BBCheckpoint &checkpoint;
+  int rank;
+  int num_procs;
+  int num_pumps;
+  int max_depth;
+  int num_screened = 0;
+  std::vector<long> num_evaluated; // children simulated at each depth
+  std::vector<long> num_feasible;  // children found feasible at each depth
+
+  //===============================================================
+  // Estimated log-size of a subtree rooted at depth d
+  //===============================================================
+  double log_size(int depth) const
+  {
+    double log_b = std::log((double)(num_pumps + 1));
+    double result = 0.0;
+    for (int h = depth + 1; h <= config.h_max; ++h)
+    {
+      // Deeper levels reuse the branching factor of the deepest level observed
+      if (h <= max_depth && num_evaluated[h] > 0)
+        log_b = std::log(std::max(1.0, (double)(num_pumps + 1) * num_feasible[h] / num_evaluated[h]));
+      result += log_b;
+    }
+    return result;
+  }
+
+  bool is_larger(const Prefix &a, const Prefix &b) const
+  {
+    if (a.depth != b.depth)
+    {
+      double size_a = log_size(a.depth), size_b = log_size(b.depth);
+      if (size_a != size_b) return size_a > size_b;
+      return a.depth < b.depth;
+    }
+    if (a.cost != b.cost) return a.cost < b.cost;
+    return a.y < b.y;
+  }
+
+  //===============================================================
+  // Simulates all children of the parents, spread over the ranks,
+  // and returns the feasible ones
+  //===============================================================
+  std::vector<Prefix> expand(const std::vector<Prefix> &parents)
+  {
+    std::vector<Prefix> children;
+    for (const Prefix &parent : parents)
+    {
+      for (int pump_state = 0; pump_state <= num_pumps; ++pump_state)
+      {
+        Prefix child = parent;
+        child.depth = parent.depth + 1;
+        child.y[child.depth] = pump_state;
+        children.push_back(std::move(child));
+      }
+    }
+
+    std::vector<double> costs(children.size(), std::numeric_limits<double>::max());
+    BBSolver solver(config, constraints, stats, progress, checkpoint);
+    for (size_t i = rank; i < children.size(); i += num_procs)
+    {
+      BBTask task;
+      task.uid = (int)i;
+      task.tid = rank;
+      task.num_pumps = num_pumps;
+      task.y = children[i].y;
+      task.h_root = children[i].depth + 1;
+      if (solver.screenTask(task) == BBPruneReason::NONE) costs[i] = task.cost_lb;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, costs.data(), (int)costs.size(), MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    num_screened += (int)children.size();
+
+    std::vector<Prefix> feasible;
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+      ++num_evaluated[children[i].depth];
+      if (costs[i] == std::numeric_limits<double>::max()) continue;
+      ++num_feasible[children[i].depth];
+      children[i].cost = costs[i];
+      feasible.push_back(std::move(children[i]));
+    }
+    return feasible;
+  }
+
+  //===============================================================
+  // Converts the frontier into tasks (largest first) and balances them
+  //===============================================================
+  void emit(std::vector<Prefix> &frontier, std::vector<BBTask> &tasks)
+  {
+    std::stable_sort(frontier.begin(), frontier.end(), [this](const Prefix &a, const Prefix &b) { return is_larger(a, b); });
+
+    double log_max = frontier.empty() ? 0.0 : log_size(frontier.front().depth);
+    std::vector<double> load(num_procs, 0.0);
+    int depth_min = config.h_max, depth_max = 0;
+    for (size_t uid = 0; uid < frontier.size(); ++uid)
+    {
+      const Prefix &prefix = frontier[uid];
+      BBTask task;
+      task.uid = (int)uid;
+      task.num_pumps = num_pumps;
+      task.y = prefix.y;
+      task.h_root = prefix.depth + 1;
+      task.cost_lb = prefix.cost;
+      task.tid = (int)(std::min_element(load.begin(), load.end()) - load.begin());
+      load[task.tid] += std::exp(log_size(prefix.depth) - log_max);
+      tasks.push_back(std::move(task));
+
+      depth_min = std::min(depth_min, prefix.depth);
+      depth_max = std::max(depth_max, prefix.depth);
+    }
+
+    if (rank == 0)
+    {
+      Console::printf(Console::Color::BRIGHT_YELLOW, "Generated %d tasks (depth %d-%d) after screening %d prefixes\n", (int)tasks.size(), depth_min,
+                      depth_max, num_screened);
+    }
+  }
+};
@@ -4,6 +4,7 @@
 #include "CLI/BBConfig.h"
 #include "CLI/BBConstraints.h"
 
+#include <cstdint>
 #include <fstream>
 #include <mpi.h>
 #include <nlohmann/json.hpp>
@@ -13,7 +14,8 @@ class BBStatistics
 public:
   std::map<BBPruneReason, std::vector<int>> data;
   std::map<BBPruneReason, std::string> labels;
-  double duration;
+  double duration = 0.0;
+  std::string stop_reason; // empty if the search was completed
 
   BBStatistics(const BBConfig &config)
   {
@@ -38,6 +40,13 @@ public:
   inline void add_stats(BBPruneReason reason, int h)
   {
     data[reason][h]++;
+    ++nodes;
+  }
+
+  // Number of nodes processed so far
+  inline long num_nodes() const
+  {
+    return nodes;
   }
 
   void to_json(char *fn) const
@@ -55,6 +64,8 @@ public:
       j[labels.at(reason)] = counts;
     }
     j["duration"] = duration;
+    j["nodes"] = nodes;
+    j["stop_reason"] = stop_reason.empty() ? "COMPLETED" : stop_reason;
     std::ofstream f(fn);
     f << j.dump(2);
   }
@@ -69,6 +80,7 @@ public:
         data[reason][h] += counts[h];
       }
     }
+    nodes += other.nodes;
   }
 
   void show() const
@@ -89,4 +101,41 @@ public:
       Console::printf(Console::Color::CYAN, "]\n");
     }
   }
+
+  // Binary serialization used by the checkpoints
+  void write(std::ostream &out) const
+  {
+    int32_t num_reasons = (int32_t)data.size();
+    out.write((const char *)&num_reasons, sizeof(num_reasons));
+    for (const auto &[reason, counts] : data)
+    {
+      int32_t header[2] = {(int32_t)reason, (int32_t)counts.size()};
+      out.write((const char *)header, sizeof(header));
+      out.write((const char *)counts.data(), counts.size() * sizeof(int));
+    }
+    int64_t num_nodes = nodes;
+    out.write((const char *)&num_nodes, sizeof(num_nodes));
+    out.write((const char *)&duration, sizeof(duration));
+  }
+
+  void read(std::istream &in)
+  {
+    int32_t num_reasons;
+    in.read((char *)&num_reasons, sizeof(num_reasons));
+    for (int i = 0; i < num_reasons; ++i)
+    {
+      int32_t header[2];
+      in.read((char *)header, sizeof(header));
+      std::vector<int> &counts = data[(BBPruneReason)header[0]];
+      counts.resize(header[1]);
+      in.read((char *)counts.data(), counts.size() * sizeof(int));
+    }
+    int64_t num_nodes;
+    in.read((char *)&num_nodes, sizeof(num_nodes));
+    nodes = num_nodes;
+    in.read((char *)&duration, sizeof(duration));
+  }
+
+private:
+  long nodes = 0;
 };
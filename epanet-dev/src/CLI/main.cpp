@@ -1,11 +1,15 @@
 // src/CLI/main.cpp
 
+#include "BBCheckpoint.h"
 #include "BBConfig.h"
+#include "BBHeuristics.h"
 #include "BBSolver.h"
+#include "BBSplitter.h"
 #include "BBStatistics.h"
 #include "Profiler.h"
 
 #include <algorithm>
+#include <limits>
 #include <mpi.h>
 #include <random>
 #include <string>
@@ -80,33 +84,103 @@ int main(int argc, char *argv[])
 
   if (rank == 0) config.show();
 
-  // Convert queue to vector for parallel processing
+  BBCheckpoint checkpoint(config, constraints, stats);
+  BBProgress progress(config);
   std::vector<BBTask> tasks;
-  populate_tasks(tasks, config, constraints);
 
-  auto tic = std::chrono::high_resolution_clock::now();
+  if (config.resume)
+  {
+    // Restart from the frontier, incumbent and statistics saved by a previous run
+    checkpoint.load(tasks);
+    constraints.sync_best_final();
+  }
+  else
+  {
+    // Seed the incumbent before any task is processed
+    if (config.use_heuristics || !config.fn_prev_best.empty())
+    {
+      BBHeuristics heuristics(config, constraints);
+      heuristics.run();
+    }
+
+    // Split the top of the tree into viable tasks, or enumerate all prefixes of length level
+    if (config.tasks_per_rank > 0)
+    {
+      BBSplitter splitter(config, constraints, stats, progress, checkpoint);
+      splitter.run(tasks);
+    }
+    else
+    {
+      populate_tasks(tasks, config, constraints);
+
+      // Screen the prefixes of this process so that its pending tasks carry a lower bound for the gap
+      // and those found infeasible are pruned here (screening counts the levels it prunes, but not actuations)
+      BBSolver solver(config, constraints, stats, progress, checkpoint);
+      for (BBTask &task : tasks)
+      {
+        if (task.tid != rank) continue;
+        BBPruneReason prune_reason = solver.screenTask(task);
+        if (prune_reason == BBPruneReason::NONE) continue;
+        if (prune_reason == BBPruneReason::ACTUATIONS) stats.add_stats(prune_reason, task.h);
+        task.cost_lb = std::numeric_limits<double>::max();
+      }
+    }
+  }
+  checkpoint.tasks = &tasks;
+  double duration_before = stats.duration;
+
+  // Lower bound of the tasks of this process not yet started (suffix minimum)
+  std::vector<double> pending_lb(tasks.size() + 1, std::numeric_limits<double>::max());
+  for (size_t i = tasks.size(); i-- > 0;)
+  {
+    pending_lb[i] = pending_lb[i + 1];
+    if (tasks[i].tid == rank) pending_lb[i] = std::min(pending_lb[i], tasks[i].cost_lb);
+  }
 
   for (size_t i = 0; i < tasks.size(); i++)
   {
+    checkpoint.next = i;
+    if (progress.stop_requested(constraints, stats)) break;
+
     // Sync best before processing each task
+    constraints.lower_bound_local = pending_lb[i];
     constraints.sync_best();
+    progress.report(constraints, stats);
+    checkpoint.save_if_due();
 
-    // Skip tasks that are not assigned to this process
+    // Skip tasks that are not assigned to this process or whose prefix was pruned when screened
     if (tasks[i].tid != rank) continue;
+    if (tasks[i].cost_lb == std::numeric_limits<double>::max()) continue;
 
     // Process the task
-    processTask(tasks[i], config, constraints, stats);
+    progress.pending_lb = pending_lb[i + 1];
+    checkpoint.next = i + 1;
+    checkpoint.current = &tasks[i];
+    processTask(tasks[i], config, constraints, stats, progress, checkpoint);
+    if (!stats.stop_reason.empty()) break;
+    checkpoint.current = nullptr;
   }
 
-  auto toc = std::chrono::high_resolution_clock::now();
-  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic);
-  stats.duration = duration.count() / 1e6; // seconds
+  stats.duration = duration_before + progress.elapsed(); // seconds, including the runs being resumed
+
+  // A stopped search can always be resumed, a completed one leaves an empty frontier
+  if (!stats.stop_reason.empty() || config.checkpoint_interval > 0)
+  {
+    if (stats.stop_reason.empty()) checkpoint.next = tasks.size();
+    checkpoint.save();
+  }
+
+  // The open nodes of a stopped search keep the last bound found, a completed search has none
+  if (stats.stop_reason.empty()) constraints.lower_bound_local = std::numeric_limits<double>::max();
 
   Console::printf(Console::Color::BRIGHT_YELLOW, "Proc %02d finished in %.3f seconds, cost(local=%s, global=%s)\n", rank, stats.duration,
                   constraints.fmt_cost(constraints.best_cost_local).c_str(), constraints.fmt_cost(constraints.best_cost_global).c_str());
   fflush(stdout);
   MPI_Barrier(MPI_COMM_WORLD);
 
+  constraints.sync_best_final();
+  progress.report(constraints, stats, true);
+
   stats.to_json(config.fn_stats);
   constraints.to_json(config.fn_best);
   Profiler::save(config.fn_profile);
@@ -53,4 +53,7 @@ const double HIGH_RESISTANCE = 1.0e8; //!< infinite flow resistance
 const double HEAD_EPSILON = 1.0e-6;   //!< negligible head value (ft)
 const double ZERO_FLOW = 1.0e-6;      //!< flow in closed link (cfs)
 
+const int DEFAULT_PARALLEL_ROWS = 10000; //!< rows needed to use threads
+                                         //!< (PARALLEL_ROWS option of 0)
+
 #endif
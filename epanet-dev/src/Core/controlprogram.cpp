@@ -0,0 +1,147 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "controlprogram.h"
+#include "Elements/control.h"
+#include "Elements/tank.h"
+#include "network.h"
+
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+ControlProgram::ControlProgram() {}
+
+ControlProgram::~ControlProgram() {}
+
+//-----------------------------------------------------------------------------
+
+void ControlProgram::clear() {
+  elapsedTimes.clear();
+  timesOfDay.clear();
+  tankLevels.clear();
+  pressures.clear();
+  fired.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Sort the network's simple controls into schedules and per node triggers.
+
+void ControlProgram::build(Network *nw) {
+  clear();
+  vector<int> tankSlot(nw->count(Element::NODE), -1);
+  vector<int> nodeSlot(nw->count(Element::NODE), -1);
+
+  for (int i = 0; i < nw->count(Element::CONTROL); i++) {
+    Control *control = nw->control(i);
+    int type = control->getType();
+    if (type == Control::ELAPSED_TIME)
+      elapsedTimes.push_back({control->getTime(), i});
+    else if (type == Control::TIME_OF_DAY)
+      timesOfDay.push_back({control->getTime(), i});
+    else if (type == Control::TANK_LEVEL || type == Control::PRESSURE_LEVEL) {
+      Node *node = control->getNode();
+      bool isTank = (type == Control::TANK_LEVEL);
+      vector<NodeTriggers> &groups = isTank ? tankLevels : pressures;
+      int &slot = isTank ? tankSlot[node->index] : nodeSlot[node->index];
+      if (slot < 0) {
+        slot = (int)groups.size();
+        groups.push_back({node, {}, {}});
+      }
+      double level = isTank ? control->getVolume() : control->getHead();
+      if (control->getLevelType() == Control::LOW_LEVEL)
+        groups[slot].low.push_back({level, i});
+      else if (control->getLevelType() == Control::HI_LEVEL)
+        groups[slot].high.push_back({level, i});
+    }
+  }
+
+  sort(elapsedTimes.begin(), elapsedTimes.end());
+  sort(timesOfDay.begin(), timesOfDay.end());
+  for (vector<NodeTriggers> *groups : {&tankLevels, &pressures}) {
+    for (NodeTriggers &triggers : *groups) {
+      sort(triggers.low.begin(), triggers.low.end());
+      sort(triggers.high.begin(), triggers.high.end());
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Add the controls of a schedule that fire at time t.
+
+void ControlProgram::addTimes(const vector<TimeTrigger> &schedule, int t) {
+  auto it = lower_bound(schedule.begin(), schedule.end(), TimeTrigger(t, -1));
+  for (; it != schedule.end() && it->first == t; ++it)
+    fired.push_back(it->second);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Activate the controls found to fire, in their input order.
+
+bool ControlProgram::activateFired(Network *nw) {
+  bool changed = false;
+  sort(fired.begin(), fired.end());
+  for (int i : fired) {
+    if (nw->control(i)->activate(true, nw->msgLog))
+      changed = true;
+  }
+  fired.clear();
+  return changed;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Apply the time and tank level controls at time t (time of day tod).
+
+void ControlProgram::apply(Network *nw, int t, int tod) {
+  addTimes(elapsedTimes, t);
+  addTimes(timesOfDay, tod);
+
+  // ... a tank's low (high) level controls fire if its volume is within
+  //     one second's worth of outflow of, or below (above), their level
+
+  for (NodeTriggers &triggers : tankLevels) {
+    Tank *tank = static_cast<Tank *>(triggers.node);
+    double v = tank->volume;
+    double dv = abs(tank->outflow);
+    auto low = partition_point(
+        triggers.low.begin(), triggers.low.end(),
+        [v, dv](const LevelTrigger &a) { return !(v <= a.first + dv); });
+    for (; low != triggers.low.end(); ++low)
+      fired.push_back(low->second);
+    auto high = triggers.high.begin();
+    for (; high != triggers.high.end() && v >= high->first - dv; ++high)
+      fired.push_back(high->second);
+  }
+  activateFired(nw);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Apply the pressure controls to the network's current heads.
+
+bool ControlProgram::applyPressureControls(Network *nw) {
+  for (NodeTriggers &triggers : pressures) {
+    double h = triggers.node->head;
+    auto low = upper_bound(triggers.low.begin(), triggers.low.end(), h,
+                           [](double h, const LevelTrigger &a) {
+                             return h < a.first;
+                           });
+    for (; low != triggers.low.end(); ++low)
+      fired.push_back(low->second);
+    auto high = triggers.high.begin();
+    for (; high != triggers.high.end() && h > high->first; ++high)
+      fired.push_back(high->second);
+  }
+  return activateFired(nw);
+}
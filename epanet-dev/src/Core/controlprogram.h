@@ -0,0 +1,67 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file controlprogram.h
+//! \brief Describes the ControlProgram class.
+
+#ifndef CONTROLPROGRAM_H_
+#define CONTROLPROGRAM_H_
+
+#include <utility>
+#include <vector>
+
+class Network;
+class Node;
+class Control;
+
+//! \class ControlProgram
+//! \brief The network's simple controls compiled for fast evaluation.
+//!
+//! Elapsed time and time of day controls are kept as schedules sorted by
+//! their trigger time, while tank level and pressure controls are grouped
+//! by the node that triggers them and sorted by their trigger level. The
+//! controls whose conditions are met are then found by binary searches
+//! instead of testing every control, and are activated in the order in
+//! which they appear in the input so that the last one acting on a link
+//! still prevails.
+
+class ControlProgram {
+public:
+  ControlProgram();
+  ~ControlProgram();
+
+  void build(Network *nw);
+  void clear();
+
+  // Applies the time and tank level controls at time t (time of day tod)
+  void apply(Network *nw, int t, int tod);
+
+  // Applies the pressure controls, returning true if any link changes
+  bool applyPressureControls(Network *nw);
+
+private:
+  typedef std::pair<int, int> TimeTrigger;     // (time, control index)
+  typedef std::pair<double, int> LevelTrigger; // (level, control index)
+
+  struct NodeTriggers {
+    Node *node;                     // node whose level triggers controls
+    std::vector<LevelTrigger> low;  // low level triggers, sorted by level
+    std::vector<LevelTrigger> high; // high level triggers, sorted by level
+  };
+
+  std::vector<TimeTrigger> elapsedTimes; // elapsed time controls
+  std::vector<TimeTrigger> timesOfDay;   // time of day controls
+  std::vector<NodeTriggers> tankLevels;  // tank level controls by tank
+  std::vector<NodeTriggers> pressures;   // pressure controls by node
+  std::vector<int> fired;                // controls whose conditions hold
+
+  void addTimes(const std::vector<TimeTrigger> &schedule, int t);
+  bool activateFired(Network *nw);
+};
+
+#endif
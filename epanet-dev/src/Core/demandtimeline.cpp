@@ -0,0 +1,182 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "demandtimeline.h"
+#include "Elements/junction.h"
+#include "Elements/pattern.h"
+#include "network.h"
+
+#include <algorithm>
+#include <numeric>
+using namespace std;
+
+static const long long MaxTableSize = 1 << 22; // max. demands tabulated
+
+// Demands of every junction over one period of the demand patterns,
+// together with the terms and pattern factors they were built from.
+//-----------------------------------------------------------------------------
+struct DemandTable {
+  int periods = 0;               // rows in the table
+  int columns = 0;               // junctions in each row
+  vector<double> values;         // periods x columns demands
+  vector<int> termBeg, termSlot; // key: terms of each junction
+  vector<double> termBase;
+  vector<vector<double>> slotFactors; // key: factors of each pattern slot
+};
+
+//-----------------------------------------------------------------------------
+
+DemandTimeline::DemandTimeline() : interval(0), patternStart(0) {}
+
+DemandTimeline::~DemandTimeline() {}
+
+//-----------------------------------------------------------------------------
+
+//  Flatten the network's junction demands and tabulate them if its demand
+//  patterns repeat.
+
+void DemandTimeline::build(Network *nw) {
+  double multiplier = nw->option(Options::DEMAND_MULTIPLIER);
+  int defaultPattern = nw->option(Options::DEMAND_PATTERN);
+  int defaultSlot = (defaultPattern >= 0) ? defaultPattern + 1 : 0;
+
+  // ... collect each junction's demand terms
+
+  junctions.clear();
+  termBeg.assign(1, 0);
+  termBase.clear();
+  termSlot.clear();
+  for (Node *node : nw->nodes) {
+    if (node->type() != Node::JUNCTION)
+      continue;
+    Junction *junc = static_cast<Junction *>(node);
+    junctions.push_back(node);
+    for (Demand &demand : junc->demands) {
+      termBase.push_back(multiplier * demand.baseDemand);
+      termSlot.push_back(demand.timePattern ? demand.timePattern->index + 1
+                                            : defaultSlot);
+    }
+    termBeg.push_back((int)termBase.size());
+  }
+  slotFactor.assign(nw->count(Element::PATTERN) + 1, 1.0);
+  patternStart = nw->option(Options::PATTERN_START);
+  table = nullptr;
+
+  // ... demands repeat only if all patterns used are fixed patterns
+  //     with a common time step
+
+  vector<bool> used(slotFactor.size(), false);
+  for (int slot : termSlot)
+    used[slot] = true;
+  interval = 0;
+  long long periods = 1;
+  int columns = (int)junctions.size();
+  for (size_t s = 1; s < used.size(); s++) {
+    if (!used[s])
+      continue;
+    Pattern *pattern = nw->pattern((int)s - 1);
+    if (pattern->type != Pattern::FIXED_PATTERN ||
+        pattern->timeInterval() <= 0)
+      return;
+    if (interval == 0)
+      interval = pattern->timeInterval();
+    else if (pattern->timeInterval() != interval)
+      return;
+    periods = lcm(periods, (long long)max(pattern->size(), 1));
+    if (periods * max(columns, 1) > MaxTableSize)
+      return;
+  }
+  if (interval == 0)
+    interval = 1;
+
+  vector<vector<double>> slotFactors(slotFactor.size());
+  for (size_t s = 1; s < used.size(); s++) {
+    if (!used[s])
+      continue;
+    Pattern *pattern = nw->pattern((int)s - 1);
+    for (int k = 0; k < pattern->size(); k++)
+      slotFactors[s].push_back(pattern->factor(k));
+  }
+
+  // ... reuse the shared table if it was built for the same demands
+
+  if (cache) {
+    lock_guard<mutex> lock(cache->mutex);
+    const DemandTable *shared = cache->table.get();
+    if (shared && shared->termBeg == termBeg &&
+        shared->termSlot == termSlot && shared->termBase == termBase &&
+        shared->slotFactors == slotFactors) {
+      table = cache->table;
+      return;
+    }
+  }
+
+  // ... sum each junction's terms in each period, in the order of its
+  //     demand list
+
+  auto newTable = make_shared<DemandTable>();
+  newTable->periods = (int)periods;
+  newTable->columns = columns;
+  newTable->values.resize(periods * columns);
+  for (int r = 0; r < periods; r++) {
+    double *row = &newTable->values[(size_t)r * columns];
+    for (int j = 0; j < columns; j++) {
+      double q = 0.0;
+      for (int k = termBeg[j]; k < termBeg[j + 1]; k++) {
+        const vector<double> &f = slotFactors[termSlot[k]];
+        double factor = f.empty() ? 1.0 : f[r % f.size()];
+        q += termBase[k] * factor;
+      }
+      row[j] = q;
+    }
+  }
+  newTable->termBeg = termBeg;
+  newTable->termSlot = termSlot;
+  newTable->termBase = termBase;
+  newTable->slotFactors = move(slotFactors);
+  table = newTable;
+
+  if (cache) {
+    lock_guard<mutex> lock(cache->mutex);
+    cache->table = newTable;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Set the full demand of each junction at elapsed time t (sec).
+
+void DemandTimeline::update(Network *nw, int t) {
+  if (termBeg.empty())
+    build(nw);
+  int columns = (int)junctions.size();
+
+  // ... copy the table row of the current pattern period
+
+  if (table) {
+    int r = ((patternStart + t) / interval) % table->periods;
+    const double *row = &table->values[(size_t)r * columns];
+    for (int j = 0; j < columns; j++) {
+      junctions[j]->fullDemand = row[j];
+      junctions[j]->actualDemand = row[j];
+    }
+    return;
+  }
+
+  // ... otherwise scale each term by its pattern's current factor
+
+  for (size_t s = 1; s < slotFactor.size(); s++)
+    slotFactor[s] = nw->pattern((int)s - 1)->currentFactor();
+  for (int j = 0; j < columns; j++) {
+    double q = 0.0;
+    for (int k = termBeg[j]; k < termBeg[j + 1]; k++)
+      q += termBase[k] * slotFactor[termSlot[k]];
+    junctions[j]->fullDemand = q;
+    junctions[j]->actualDemand = q;
+  }
+}
@@ -0,0 +1,73 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file demandtimeline.h
+//! \brief Describes the DemandTimeline class.
+
+#ifndef DEMANDTIMELINE_H_
+#define DEMANDTIMELINE_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Network;
+class Node;
+struct DemandTable;
+
+//! \struct DemandTableCache
+//! \brief The demand table last built by the engines sharing it.
+//!
+//! The hydraulic engines of projects that load the same network (e.g. one
+//! per branch-and-bound task) can share one of these, so that only the
+//! first of them tabulates the junction demands.
+
+struct DemandTableCache {
+  std::mutex mutex;
+  std::shared_ptr<const DemandTable> table;
+};
+
+//! \class DemandTimeline
+//! \brief Supplies the full demand of every junction at each time step.
+//!
+//! The demand categories of all junctions are flattened into contiguous
+//! terms of (multiplier * base demand, time pattern) when the hydraulic
+//! engine is initialized. If every pattern those terms use is a fixed
+//! pattern stepping at a common interval, the demands repeat with a period
+//! of the least common multiple of the pattern lengths, and a table of
+//! each junction's demand over one such period is built up front; a time
+//! step then only copies one row of it. With a DemandTableCache the table
+//! is shared read-only with the other timelines using the same cache that
+//! have the same demands. In all other cases the terms are summed with the
+//! current pattern factors.
+
+class DemandTimeline {
+public:
+  DemandTimeline();
+  ~DemandTimeline();
+
+  void shareTable(std::shared_ptr<DemandTableCache> cache_) {
+    cache = cache_;
+  }
+  void build(Network *nw);
+  void update(Network *nw, int t);
+  bool isTabulated() const { return table != nullptr; }
+
+private:
+  std::vector<Node *> junctions; // junction nodes
+  std::vector<int> termBeg;      // start of each junction's terms
+  std::vector<double> termBase;  // multiplier * base demand of each term
+  std::vector<int> termSlot;     // 0 (no pattern) or pattern index + 1
+  std::vector<double> slotFactor; // current factor of each pattern slot
+  int interval;                  // common pattern time step (sec)
+  int patternStart;              // time offset of the patterns (sec)
+  std::shared_ptr<const DemandTable> table; // demands over one period
+  std::shared_ptr<DemandTableCache> cache;  // table shared with others
+};
+
+#endif
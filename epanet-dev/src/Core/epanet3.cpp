@@ -306,4 +306,12 @@ int EN_getLinkValue(int index, int param, double *value, EN_Project p) {
                                    project(p)->getNetwork());
 }
 
+//-----------------------------------------------------------------------------
+
+int EN_getSegmentStats(int *liveSegs, int *freeSegs, double *bytes,
+                       EN_Project p) {
+  project(p)->getSegmentStats(*liveSegs, *freeSegs, *bytes);
+  return 0;
+}
+
 } // end of namespace
@@ -0,0 +1,206 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "eventqueue.h"
+#include "Elements/control.h"
+#include "Elements/pattern.h"
+#include "Elements/tank.h"
+#include "network.h"
+
+#include <limits>
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+EventQueue::EventQueue()
+    : lastTime(0), patternsBuilt(false), controlsBuilt(false) {}
+
+EventQueue::~EventQueue() {}
+
+//-----------------------------------------------------------------------------
+
+//  Collect the network's tanks and tank level controls; pattern and time
+//  control events are found when first queried.
+
+void EventQueue::build(Network *nw) {
+  tanks.clear();
+  for (Node *node : nw->nodes) {
+    if (node->type() == Node::TANK)
+      tanks.push_back(static_cast<Tank *>(node));
+  }
+  levelControls.clear();
+  for (Control *control : nw->controls) {
+    if (control->getType() == Control::TANK_LEVEL)
+      levelControls.push_back(control);
+  }
+  patternsBuilt = false;
+  controlsBuilt = false;
+  lastTime = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Discard all events if the clock has moved back to time t.
+
+void EventQueue::checkClock(int t) {
+  if (t < lastTime) {
+    patternsBuilt = false;
+    controlsBuilt = false;
+  }
+  lastTime = t;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Add the next change of pattern i as seen at time t.
+
+void EventQueue::addPatternEvent(Network *nw, int i, int t) {
+  Pattern *pattern = nw->pattern(i);
+  int next = pattern->nextTime(t);
+
+  // ... a fixed pattern's next change time moves on once the clock enters
+  //     its next period; a variable pattern's once it is advanced past it
+
+  int validTo = next;
+  if (pattern->type == Pattern::FIXED_PATTERN)
+    validTo = next - static_cast<FixedPattern *>(pattern)->timeOffset();
+  if (validTo <= t)
+    validTo = t + 1;
+
+  patternTime[i] = next;
+  patternValidTo[i] = validTo;
+  patternEvents.insert({next, i});
+  patternExpiry.insert({validTo, i});
+}
+
+//-----------------------------------------------------------------------------
+
+//  Add the next firing of time control i as seen at time t (time of day tod).
+
+void EventQueue::addControlEvent(Control *control, int i, int t, int tod) {
+  int time = control->getTime();
+  if (control->getType() == Control::ELAPSED_TIME) {
+    if (time > t)
+      controlEvents.insert({time, i});
+  } else if (control->getType() == Control::TIME_OF_DAY) {
+    int dt = (time >= tod) ? time - tod : 86400 - tod + time;
+    if (dt == 0)
+      dt = 86400;
+    controlEvents.insert({t + dt, i});
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find shortest time until next change for all time patterns.
+
+int EventQueue::timeToPatternChange(Network *nw, int t, int tstep,
+                                    Pattern *&pattern) {
+  checkClock(t);
+  int patternCount = nw->count(Element::PATTERN);
+  if (!patternsBuilt || (int)patternTime.size() != patternCount) {
+    patternEvents.clear();
+    patternExpiry.clear();
+    patternTime.assign(patternCount, 0);
+    patternValidTo.assign(patternCount, 0);
+    for (int i = 0; i < patternCount; i++)
+      addPatternEvent(nw, i, t);
+    patternsBuilt = true;
+  }
+
+  // ... refresh the entries that have expired
+
+  while (!patternExpiry.empty() && patternExpiry.begin()->first <= t) {
+    int i = patternExpiry.begin()->second;
+    patternExpiry.erase(patternExpiry.begin());
+    patternEvents.erase({patternTime[i], i});
+    addPatternEvent(nw, i, t);
+  }
+
+  // ... earliest change still ahead of t (ties go to the lowest index)
+
+  pattern = nullptr;
+  for (const Event &event : patternEvents) {
+    int dt = event.first - t;
+    if (dt >= tstep)
+      break;
+    if (dt > 0) {
+      tstep = dt;
+      pattern = nw->pattern(event.second);
+      break;
+    }
+  }
+  return tstep;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the shortest time to completely fill or empty all tanks.
+
+int EventQueue::timeToCloseTank(int tstep, Tank *&closedTank) {
+  closedTank = nullptr;
+  for (Tank *tank : tanks) {
+    int t = tank->timeToVolume(tank->minVolume);
+    if (t <= 0)
+      t = tank->timeToVolume(tank->maxVolume);
+    if (t > 0 && t < tstep) {
+      tstep = t;
+      closedTank = tank;
+    }
+  }
+  return tstep;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the shortest time to activate a simple control.
+
+int EventQueue::timeToActivateControl(Network *nw, int t, int tod, int tstep,
+                                      bool &activated) {
+  checkClock(t);
+  activated = false;
+
+  // ... tank level controls depend on the tanks' current state
+
+  for (Control *control : levelControls) {
+    int dt = control->timeToActivate(nw, t, tod);
+    if (dt > 0 && dt < tstep) {
+      tstep = dt;
+      activated = true;
+    }
+  }
+
+  // ... time controls, in order of firing time
+
+  if (!controlsBuilt) {
+    controlEvents.clear();
+    for (int i = 0; i < nw->count(Element::CONTROL); i++)
+      addControlEvent(nw->control(i), i, t, tod);
+    controlsBuilt = true;
+  }
+  while (!controlEvents.empty() && controlEvents.begin()->first <= t) {
+    int i = controlEvents.begin()->second;
+    controlEvents.erase(controlEvents.begin());
+    addControlEvent(nw->control(i), i, t, tod);
+  }
+
+  // ... the first one that would change its link's status or setting
+  //     (timeToActivate() returns -1 for those that would not)
+
+  for (const Event &event : controlEvents) {
+    if (event.first - t >= tstep)
+      break;
+    int dt = nw->control(event.second)->timeToActivate(nw, t, tod);
+    if (dt > 0 && dt < tstep) {
+      tstep = dt;
+      activated = true;
+      break;
+    }
+  }
+  return tstep;
+}
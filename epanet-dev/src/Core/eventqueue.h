@@ -0,0 +1,71 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file eventqueue.h
+//! \brief Describes the EventQueue class.
+
+#ifndef EVENTQUEUE_H_
+#define EVENTQUEUE_H_
+
+#include <set>
+#include <utility>
+#include <vector>
+
+class Network;
+class Pattern;
+class Tank;
+class Control;
+
+//! \class EventQueue
+//! \brief Finds the next hydraulic event without scanning every element.
+//!
+//! The time at which each time pattern next changes and the time at which
+//! each elapsed time or time of day control next fires are kept in ordered
+//! sets, together with the time up to which each pattern's entry holds.
+//! Only entries that have expired as the simulation clock advanced are
+//! recomputed, so finding the next event costs a logarithmic number of
+//! operations rather than a scan of all patterns and controls. The queue
+//! is rebuilt whenever the clock moves backwards (e.g. when a saved
+//! engine state is restored). Tank volumes change at every step, so tank
+//! and tank level control times are found from short lists of those
+//! elements only.
+
+class EventQueue {
+public:
+  EventQueue();
+  ~EventQueue();
+
+  void build(Network *nw);
+
+  //! Each function returns the smaller of tstep and the time (sec) from
+  //! t to the next event of its kind, identifying the element causing it.
+  int timeToPatternChange(Network *nw, int t, int tstep, Pattern *&pattern);
+  int timeToCloseTank(int tstep, Tank *&tank);
+  int timeToActivateControl(Network *nw, int t, int tod, int tstep,
+                            bool &activated);
+
+private:
+  typedef std::pair<int, int> Event; // (time, element index)
+
+  int lastTime;                         // time of the last query (sec)
+  bool patternsBuilt;                   // true if pattern events are set
+  bool controlsBuilt;                   // true if control events are set
+  std::set<Event> patternEvents;        // next change of each pattern
+  std::set<Event> patternExpiry;        // time each pattern entry expires
+  std::vector<int> patternTime;         // next change time of each pattern
+  std::vector<int> patternValidTo;      // expiry time of each pattern entry
+  std::set<Event> controlEvents;        // next firing of each time control
+  std::vector<Tank *> tanks;            // all tanks
+  std::vector<Control *> levelControls; // tank level controls
+
+  void checkClock(int t);
+  void addPatternEvent(Network *nw, int i, int t);
+  void addControlEvent(Control *control, int i, int t, int tod);
+};
+
+#endif
@@ -13,99 +13,220 @@
 // - compute and report system wide cumulative flow balance
 
 #include "hydbalance.h"
+#include "Core/constants.h"
+#include "Elements/junction.h"
 #include "Elements/link.h"
 #include "Elements/node.h"
 #include "network.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 using namespace std;
 
-void findNodeOutflows(double lamda, double dH[], double xQ[], Network *nw);
-void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw);
-double findTotalFlowChange(double lamda, double dQ[], Network *nw);
+//  Partial results of a pass over one block of links or nodes.
+
+struct BalancePartial {
+  double norm = 0.0;     // sum of squared errors
+  double maxErr = 0.0;   // max. head loss or flow error
+  int maxErrIndex = -1;  // element with the max. error
+  double maxChange = 0.0; // max. flow change
+  int maxChangeIndex = 0; // link with the max. flow change
+  double qSum = 0.0;     // sum of link flows
+  double dqSum = 0.0;    // sum of link flow changes
+};
+
+static int threadCount(int n, int parallelSize) {
+#ifdef _OPENMP
+  if (n >= parallelSize)
+    return omp_get_max_threads();
+#endif
+  return 1;
+}
+
+static void findBlock(int n, int nBlocks, int b, int &first, int &last) {
+  first = (int)((long long)n * b / nBlocks);
+  last = (int)((long long)n * (b + 1) / nBlocks);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Save the network's topology in contiguous form: the end nodes of each
+//  link and, for each node, the links incident on it in index order with
+//  the sign their flow carries into the node's balance.
+
+void HydBalance::init(Network *nw) {
+  int nodeCount = nw->count(Element::NODE);
+  int linkCount = nw->count(Element::LINK);
+  parallelSize = nw->option(Options::PARALLEL_ROWS);
+  if (parallelSize <= 0)
+    parallelSize = DEFAULT_PARALLEL_ROWS;
+
+  fromNode.resize(linkCount);
+  toNode.resize(linkCount);
+  adjBeg.assign(nodeCount + 1, 0);
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = nw->link(i);
+    fromNode[i] = link->fromNode->index;
+    toNode[i] = link->toNode->index;
+    adjBeg[fromNode[i] + 1]++;
+    adjBeg[toNode[i] + 1]++;
+  }
+  for (int i = 0; i < nodeCount; i++)
+    adjBeg[i + 1] += adjBeg[i];
+
+  vector<int> next(adjBeg.begin(), adjBeg.end() - 1);
+  adjLink.resize(2 * linkCount);
+  adjSign.resize(2 * linkCount);
+  for (int i = 0; i < linkCount; i++) {
+    int k = next[fromNode[i]]++;
+    adjLink[k] = i;
+    adjSign[k] = -1.0;
+    k = next[toNode[i]]++;
+    adjLink[k] = i;
+    adjSign[k] = 1.0;
+  }
+
+  isJunction.resize(nodeCount);
+  for (int i = 0; i < nodeCount; i++)
+    isJunction[i] = (nw->node(i)->type() == Node::JUNCTION);
+
+  trialHead.assign(nodeCount, 0.0);
+  trialFlow.assign(linkCount, 0.0);
+  leakFlow.assign(2 * linkCount, 0.0);
+  leakGrad.assign(2 * linkCount, 0.0);
+}
 
 //-----------------------------------------------------------------------------
 
 //  Evaluate the error in satisfying the conservation of flow and energy
 //  equations by an updated set of network heads and flows.
 //
+//  The evaluation streams over the nodes once to form trial heads, over
+//  the links once to find flows, head losses, leakage and the head loss
+//  error norm, and over the nodes once more to gather each node's flow
+//  balance, outflows and the flow error norm. Nodes gather their link
+//  flows instead of links scattering them, so both element passes can be
+//  split into blocks that run on separate threads for large networks;
+//  the block results are combined in block order.
 
 double HydBalance::evaluate(double lamda, // step size
                             double dH[],  // change in nodal heads
                             double dQ[],  // change in link flows
+                            double dD[],  // change in pressure driven demands
                             double xQ[],  // nodal inflow minus outflow
                             Network *nw)  // network being analyzed
 {
-  // ... initialize which elements have the maximum errors
-  maxFlowErr = 0.0;
-  maxHeadErr = 0.0;
-  maxFlowChange = 0.0;
-  maxHeadErrLink = -1;
-  maxFlowErrNode = -1;
-  maxFlowChangeLink = -1;
+  int nodeCount = nw->count(Element::NODE);
+  int linkCount = nw->count(Element::LINK);
+  if ((int)fromNode.size() != linkCount || (int)isJunction.size() != nodeCount)
+    init(nw);
 
-  // ... initialize nodal flow imbalances to 0
+  // ... trial heads
 
-  int nodeCount = nw->count(Element::NODE);
-  memset(&xQ[0], 0, nodeCount * sizeof(double));
+#pragma omp parallel for if (nodeCount >= parallelSize)
+  for (int i = 0; i < nodeCount; i++)
+    trialHead[i] = nw->node(i)->head + lamda * dH[i];
 
   // ... find the error norm in satisfying conservation of energy
-  //     (updating xQ with internal link flows)
 
-  double norm = findHeadErrorNorm(lamda, dH, dQ, xQ, nw);
-
-  // ... update xQ with external outflows
+  int nBlocks = threadCount(linkCount, parallelSize);
+  vector<BalancePartial> linkParts(nBlocks);
+#pragma omp parallel for num_threads(nBlocks) if (nBlocks > 1)
+  for (int b = 0; b < nBlocks; b++) {
+    int first, last;
+    findBlock(linkCount, nBlocks, b, first, last);
+    findLinkErrors(lamda, dQ, nw, first, last, linkParts[b]);
+  }
 
-  findNodeOutflows(lamda, dH, xQ, nw);
+  maxHeadErr = 0.0;
+  maxHeadErrLink = -1;
+  maxFlowChange = 0.0;
+  maxFlowChangeLink = 0;
+  double headNorm = 0.0;
+  double qSum = 0.0;
+  double dqSum = 0.0;
+  for (BalancePartial &part : linkParts) {
+    headNorm += part.norm;
+    qSum += part.qSum;
+    dqSum += part.dqSum;
+    if (part.maxErr > maxHeadErr) {
+      maxHeadErr = part.maxErr;
+      maxHeadErrLink = part.maxErrIndex;
+    }
+    if (part.maxChange > maxFlowChange) {
+      maxFlowChange = part.maxChange;
+      maxFlowChangeLink = part.maxChangeIndex;
+    }
+  }
 
   // ... add the error norm in satisfying conservation of flow
 
-  norm += findFlowErrorNorm(xQ, nw);
+  nBlocks = threadCount(nodeCount, parallelSize);
+  vector<BalancePartial> nodeParts(nBlocks);
+#pragma omp parallel for num_threads(nBlocks) if (nBlocks > 1)
+  for (int b = 0; b < nBlocks; b++) {
+    int first, last;
+    findBlock(nodeCount, nBlocks, b, first, last);
+    findNodeErrors(lamda, dD, xQ, nw, first, last, nodeParts[b]);
+  }
 
-  // ... evaluate the total relative flow change
+  maxFlowErr = 0.0;
+  maxFlowErrNode = -1;
+  double flowNorm = 0.0;
+  for (BalancePartial &part : nodeParts) {
+    flowNorm += part.norm;
+    qSum += part.qSum;
+    dqSum += part.dqSum;
+    if (part.maxErr > maxFlowErr) {
+      maxFlowErr = part.maxErr;
+      maxFlowErrNode = part.maxErrIndex;
+    }
+  }
+
+  // ... evaluate the total relative flow change (including the changes
+  //     in pressure driven demands)
 
-  totalFlowChange = findTotalFlowChange(lamda, dQ, nw);
+  if (qSum > 0.0)
+    totalFlowChange = dqSum / qSum;
+  else
+    totalFlowChange = dqSum;
 
   // ... return the root mean square error
 
+  double norm = (linkCount > 0) ? headNorm / linkCount : 0.0;
+  norm += flowNorm / nodeCount;
   return sqrt(norm);
 }
 
 //-----------------------------------------------------------------------------
 
-//  Find the error norm in satisfying the head loss equation across each link.
-
-double HydBalance::findHeadErrorNorm(double lamda, double dH[], double dQ[],
-                                     double xQ[], Network *nw) {
-  double norm = 0.0;
-  double count = 0.0;
-  maxHeadErr = 0.0;
-  maxFlowChange = 0.0;
-  maxFlowChangeLink = 0;
-
-  int linkCount = nw->count(Element::LINK);
-  for (int i = 0; i < linkCount; i++) {
-    // ... identify link's end nodes
+//  Find the flow, head loss, head loss error and leakage of links first
+//  through last-1.
 
+void HydBalance::findLinkErrors(double lamda, double dQ[], Network *nw,
+                                int first, int last, BalancePartial &part) {
+  for (int i = first; i < last; i++) {
     Link *link = nw->link(i);
-    int n1 = link->fromNode->index;
-    int n2 = link->toNode->index;
+    int n1 = fromNode[i];
+    int n2 = toNode[i];
 
-    // ... apply updated flow to end node flow balances
+    // ... updated flow and the network's max. flow change
 
     double flowChange = lamda * dQ[i];
     double flow = link->flow + flowChange;
-    xQ[n1] -= flow;
-    xQ[n2] += flow;
-
-    // ... update network's max. flow change
+    trialFlow[i] = flow;
 
     double err = abs(flowChange);
-    if (err > maxFlowChange) {
-      maxFlowChange = err;
-      maxFlowChangeLink = i;
+    if (err > part.maxChange) {
+      part.maxChange = err;
+      part.maxChangeIndex = i;
     }
+    part.dqSum += err;
+    part.qSum += abs(flow);
 
     // ... compute head loss and its gradient (head loss is saved
     // ... to link->hLoss and its gradient to link->hGrad)
@@ -115,203 +236,181 @@ double HydBalance::findHeadErrorNorm(double lamda, double dH[], double dQ[],
 
     // ... evaluate head loss error
 
-    double h1 = link->fromNode->head + lamda * dH[n1];
-    double h2 = link->toNode->head + lamda * dH[n2];
+    double h1 = trialHead[n1];
+    double h2 = trialHead[n2];
     if (link->hGrad == 0.0)
       link->hLoss = h1 - h2;
     err = h1 - h2 - link->hLoss;
-    if (abs(err) > maxHeadErr) {
-      maxHeadErr = abs(err);
-      maxHeadErrLink = i;
+    if (abs(err) > part.maxErr) {
+      part.maxErr = abs(err);
+      part.maxErrIndex = i;
     }
 
     // ... update sum of squared errors
 
-    norm += err * err;
-    count += 1.0;
-  }
+    part.norm += err * err;
 
-  // ... return sum of squared errors normalized by link count
+    // ... leakage flow withdrawn at each end node
 
-  if (count == 0.0)
-    return 0;
-  else
-    return norm / count;
+    if (nw->leakageModel)
+      findLeakage(link, nw, i);
+  }
 }
 
 //-----------------------------------------------------------------------------
 
-//  Find net external outflow at each network node.
+//  Find the leakage along link i and the share of it (and of its gradient)
+//  withdrawn at each of its end nodes.
 
-void findNodeOutflows(double lamda, double dH[], double xQ[], Network *nw) {
-  // ... initialize node outflows and their gradients w.r.t. head
+void HydBalance::findLeakage(Link *link, Network *nw, int i) {
+  double *q1 = &leakFlow[2 * i];
+  double *g1 = &leakGrad[2 * i];
+  q1[0] = q1[1] = 0.0;
+  g1[0] = g1[1] = 0.0;
 
-  for (Node *node : nw->nodes) {
-    node->outflow = 0.0;
-    node->qGrad = 0.0;
-  }
+  // ... skip links that don't leak
 
-  // ... find pipe leakage flows & assign them to node outflows
+  link->leakage = 0.0;
+  double dqdh = 0.0;
+  if (!link->canLeak())
+    return;
 
-  if (nw->leakageModel)
-    findLeakageFlows(lamda, dH, xQ, nw);
+  // ... no leakage if neither end node is a junction
 
-  // ... add emitter flows and demands to node outflows
+  int n1 = fromNode[i];
+  int n2 = toNode[i];
+  bool canLeak1 = isJunction[n1];
+  bool canLeak2 = isJunction[n2];
+  if (!canLeak1 && !canLeak2)
+    return;
 
-  int nodeCount = nw->count(Element::NODE);
-  for (int i = 0; i < nodeCount; i++) {
+  // ... find link's average pressure head
+
+  double h1 = trialHead[n1] - link->fromNode->elev;
+  double h2 = trialHead[n2] - link->toNode->elev;
+  double h = (h1 + h2) / 2.0;
+  if (h <= 0.0)
+    return;
+
+  // ... find leakage and its gradient
+
+  link->leakage = link->findLeakage(nw, h, dqdh);
+
+  // ... split leakage flow between end nodes, unless one cannot
+  //     support leakage or has negative pressure head
+
+  double q = link->leakage / 2.0;
+  if (h1 * h2 <= 0.0 || canLeak1 * canLeak2 == 0)
+    q = 2.0 * q;
+
+  if (h1 > 0.0 && canLeak1) {
+    q1[0] = q;
+    g1[0] = dqdh;
+  }
+  if (h2 > 0.0 && canLeak2) {
+    q1[1] = q;
+    g1[1] = dqdh;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the flow balance, external outflow and flow error of nodes first
+//  through last-1.
+
+void HydBalance::findNodeErrors(double lamda, double dD[], double xQ[],
+                                Network *nw, int first, int last,
+                                BalancePartial &part) {
+  bool pressureDriven = nw->demandModel->isPressureDriven();
+  for (int i = first; i < last; i++) {
     Node *node = nw->node(i);
-    double h = node->head + lamda * dH[i];
-    double q = 0.0;
-    double dqdh = 0.0;
+
+    // ... internal link flows into the node
+
+    double x = 0.0;
+    for (int k = adjBeg[i]; k < adjBeg[i + 1]; k++)
+      x += adjSign[k] * trialFlow[adjLink[k]];
+
+    // ... pipe leakage assigned to the node
+
+    node->outflow = 0.0;
+    node->qGrad = 0.0;
+    if (nw->leakageModel) {
+      for (int k = adjBeg[i]; k < adjBeg[i + 1]; k++) {
+        int m = 2 * adjLink[k] + (adjSign[k] > 0.0);
+        node->outflow += leakFlow[m];
+        node->qGrad += leakGrad[m];
+        x -= leakFlow[m];
+      }
+    }
 
     // ... for junctions, outflow depends on head
 
-    if (node->type() == Node::JUNCTION) {
+    double demandErr = 0.0;
+    if (isJunction[i]) {
+      double h = trialHead[i];
+      double dqdh = 0.0;
+
       // ... contribution from emitter flow
 
-      q = node->findEmitterFlow(h, dqdh);
+      double q = node->findEmitterFlow(h, dqdh);
       node->qGrad += dqdh;
       node->outflow += q;
-      xQ[i] -= q;
+      x -= q;
 
       // ... contribution from demand flow
 
       // ... for fixed grade junction, demand is remaining flow excess
       if (node->fixedGrade) {
-        q = xQ[i];
-        xQ[i] -= q;
+        q = x;
+        x -= q;
+        node->actualDemand = q;
+      }
+
+      // ... a pressure driven demand is a flow of its own (kept between
+      //     zero and full demand), whose error in meeting the demand-
+      //     pressure curve (as a flow) counts as a flow error
+      else if (pressureDriven && node->fullDemand > 0.0) {
+        Junction *junc = static_cast<Junction *>(node);
+        q = node->actualDemand + lamda * dD[i];
+        q = min(max(q, 0.0), node->fullDemand);
+        part.dqSum += abs(q - node->actualDemand);
+        part.qSum += q;
+        double dpdq = 0.0;
+        double p = junc->findDemandPressure(nw, q, h, dpdq);
+        node->qGrad += 1.0 / dpdq;
+        demandErr = (h - node->elev - p) / dpdq;
+        x -= q;
       }
 
       // ... otherwise junction has pressure-dependent demand
       else {
         q = node->findActualDemand(nw, h, dqdh);
         node->qGrad += dqdh;
-        xQ[i] -= q;
+        x -= q;
+        node->actualDemand = q;
       }
-      node->actualDemand = q;
       node->outflow += q;
     }
 
     // ... for tanks and reservoirs all flow excess becomes outflow
 
     else {
-      node->outflow = xQ[i];
-      xQ[i] = 0.0;
+      node->outflow = x;
+      x = 0.0;
     }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-//  Find the error norm in satisfying flow continuity at each node.
-
-double HydBalance::findFlowErrorNorm(double xQ[], Network *nw) {
-  // Note: contributions to the nodal flow imbalance array xQ[] were
-  //       found previously from findHeadErrorNorm() and findNodeOutflows())
 
-  double norm = 0.0;
-  maxFlowErr = 0.0;
-
-  int nodeCount = nw->count(Element::NODE);
-  for (int i = 0; i < nodeCount; i++) {
-    // ... update network's max. flow error
+    // ... update network's max. flow error and sum of squared errors
 
-    if (abs(xQ[i]) > maxFlowErr) {
-      maxFlowErr = abs(xQ[i]);
-      maxFlowErrNode = i;
+    xQ[i] = x;
+    if (abs(x) > part.maxErr) {
+      part.maxErr = abs(x);
+      part.maxErrIndex = i;
     }
-
-    // ... update sum of squared errors (flow imbalances)
-
-    norm += xQ[i] * xQ[i];
-  }
-
-  // ... return sum of squared errors normalized by number of nodes
-
-  return norm / nodeCount;
-}
-
-//-----------------------------------------------------------------------------
-
-//  Assign the leakage flow along each network pipe to its end nodes.
-
-void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw) {
-  double dqdh = 0.0; // gradient of leakage outflow w.r.t. pressure head
-
-  for (Link *link : nw->links) {
-    // ... skip links that don't leak
-
-    link->leakage = 0.0;
-    dqdh = 0.0;
-    if (!link->canLeak())
-      continue;
-
-    // ... identify link's end nodes and their indexes
-
-    Node *node1 = link->fromNode;
-    Node *node2 = link->toNode;
-    int n1 = node1->index;
-    int n2 = node2->index;
-
-    // ... no leakage if neither end node is not a junction
-
-    bool canLeak1 = (node1->type() == Node::JUNCTION);
-    bool canLeak2 = (node2->type() == Node::JUNCTION);
-    if (!canLeak1 && !canLeak2)
-      continue;
-
-    // ... find link's average pressure head
-
-    double h1 = node1->head + lamda * dH[n1] - node1->elev;
-    double h2 = node2->head + lamda * dH[n2] - node2->elev;
-    double h = (h1 + h2) / 2.0;
-    if (h <= 0.0)
-      continue;
-
-    // ... find leakage and its gradient
-
-    link->leakage = link->findLeakage(nw, h, dqdh);
-
-    // ... split leakage flow between end nodes, unless one cannot
-    //     support leakage or has negative pressure head
-
-    double q = link->leakage / 2.0;
-    if (h1 * h2 <= 0.0 || canLeak1 * canLeak2 == 0)
-      q = 2.0 * q;
-
-    // ... add leakage to each node's outflow
-
-    if (h1 > 0.0 && canLeak1) {
-      node1->outflow += q;
-      node1->qGrad += dqdh;
-      xQ[n1] -= q;
-    }
-    if (h2 > 0.0 && canLeak2) {
-      node2->outflow += q;
-      node2->qGrad += dqdh;
-      xQ[n2] -= q;
+    if (abs(demandErr) > part.maxErr) {
+      part.maxErr = abs(demandErr);
+      part.maxErrIndex = i;
     }
+    part.norm += x * x + demandErr * demandErr;
   }
 }
-
-//-----------------------------------------------------------------------------
-
-//  Find the sum of all link flow changes relative to the sum of all link flows.
-
-double findTotalFlowChange(double lamda, double dQ[], Network *nw) {
-  double qSum = 0.0;
-  double dqSum = 0.0;
-  double dq;
-
-  for (int i = 0; i < nw->count(Element::LINK); i++) {
-    Link *link = nw->link(i);
-    dq = lamda * dQ[i];
-    dqSum += abs(dq);
-    qSum += abs(link->flow + dq);
-  }
-  if (qSum > 0.0)
-    return dqSum / qSum;
-  else
-    return dqSum;
-}
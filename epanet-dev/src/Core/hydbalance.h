@@ -17,6 +17,8 @@
 #include <vector>
 
 class Network;
+class Link;
+struct BalancePartial;
 
 class HydBalanceData {
 public:
@@ -35,6 +37,9 @@ public:
 //! The HydBalance class determines the error in satisfying the head loss
 //! equation across each link and the flow continuity equation at each node
 //! of the network for an incremental change in nodal heads and link flows.
+//! It keeps the network's topology in contiguous arrays so that each
+//! evaluation makes one streaming pass over the links and one over the
+//! nodes, both of which are multi-threaded on large networks.
 
 struct HydBalance {
   double maxFlowErr;      //!< max. flow error (cfs)
@@ -46,11 +51,9 @@ struct HydBalance {
   int maxFlowErrNode;    //!< node with max. flow error
   int maxFlowChangeLink; //!< link with max. flow change
 
-  double evaluate(double lamda, double dH[], double dQ[], double xQ[],
-                  Network *nw);
-  double findHeadErrorNorm(double lamda, double dH[], double dQ[], double xQ[],
-                           Network *nw);
-  double findFlowErrorNorm(double xQ[], Network *nw);
+  void init(Network *nw);
+  double evaluate(double lamda, double dH[], double dQ[], double dD[],
+                  double xQ[], Network *nw);
 
   //! Serialize to JSON for HydBalance
   nlohmann::json to_json() const {
@@ -93,6 +96,28 @@ struct HydBalance {
     maxFlowErrNode = data.maxFlowErrNode;
     maxFlowChangeLink = data.maxFlowChangeLink;
   }
+
+private:
+  // network topology in contiguous form
+  std::vector<int> fromNode;      // start node of each link
+  std::vector<int> toNode;        // end node of each link
+  std::vector<int> adjBeg;        // start of each node's entries in adjLink
+  std::vector<int> adjLink;       // links incident on each node
+  std::vector<double> adjSign;    // -1 if the node is the link's start node
+  std::vector<char> isJunction;   // true if a node is a junction
+  int parallelSize;               // elements needed to use threads
+
+  // per-evaluation work arrays
+  std::vector<double> trialHead;  // updated head of each node
+  std::vector<double> trialFlow;  // updated flow of each link
+  std::vector<double> leakFlow;   // leakage withdrawn at each link end
+  std::vector<double> leakGrad;   // leakage gradient at each link end
+
+  void findLinkErrors(double lamda, double dQ[], Network *nw, int first,
+                      int last, BalancePartial &part);
+  void findLeakage(Link *link, Network *nw, int i);
+  void findNodeErrors(double lamda, double dD[], double xQ[], Network *nw,
+                      int first, int last, BalancePartial &part);
 };
 
 #endif
@@ -18,6 +18,8 @@
 #include "Elements/link.h"
 #include "Elements/pattern.h"
 #include "Elements/tank.h"
+#include "Output/hydfile.h"
+#include "Solvers/ggasolver.h"
 #include "Solvers/hydsolver.h"
 #include "Solvers/matrixsolver.h"
 #include "Utilities/utilities.h"
@@ -41,13 +43,6 @@ static const string s_IllConditioned =
 static const string s_Balanced = "  Network balanced in ";
 static const string s_Trials = " trials.";
 static const string s_Deficient = " nodes were pressure deficient.";
-static const string s_ReSolve1 =
-    "\n    Re-solving network with these made fixed grade.";
-static const string s_Reductions1 = " nodes require demand reductions.";
-static const string s_ReSolve2 =
-    "\n    Re-solving network with these reductions made.";
-static const string s_Reductions2 =
-    " nodes require further demand reductions to 0.";
 
 //-----------------------------------------------------------------------------
 
@@ -55,8 +50,9 @@ static const string s_Reductions2 =
 
 HydEngine::HydEngine()
     : engineState(HydEngine::CLOSED), network(nullptr), hydSolver(nullptr),
-      matrixSolver(nullptr), saveToFile(false), halted(false), startTime(0),
-      rptTime(0), hydStep(0), currentTime(0), timeOfDay(0), peakKwatts(0.0) {}
+      matrixSolver(nullptr), hydFile(nullptr), saveToFile(false),
+      readFromFile(false), halted(false), startTime(0), rptTime(0), hydStep(0),
+      currentTime(0), timeOfDay(0), peakKwatts(0.0), deficientNodes(0) {}
 
 //-----------------------------------------------------------------------------
 
@@ -92,6 +88,10 @@ void HydEngine::open(Network *nw) {
   if (matrixSolver == nullptr) {
     throw SystemError(SystemError::MATRIX_SOLVER_NOT_OPENED);
   }
+  matrixSolver->setOrdering(network->option(Options::MATRIX_ORDERING));
+  matrixSolver->setPrecision(network->option(Options::MATRIX_PRECISION));
+  matrixSolver->setParallelRows(network->option(Options::PARALLEL_ROWS));
+  matrixSolver->shareSymbolicFactor(symbolicFactor);
   initMatrixSolver();
 
   // ... create a hydraulic solver
@@ -126,6 +126,27 @@ void HydEngine::init(bool initFlows) {
   for (Pattern *pattern : network->patterns) {
     pattern->init(patternStep, patternStart);
   }
+  demandTimeline.build(network);
+  eventQueue.build(network);
+  network->controlProgram.build(network);
+
+  // ... open a hydraulics file to save results to or read them from
+
+  saveToFile = false;
+  readFromFile = false;
+  int fileMode = network->option(Options::HYD_FILE_MODE);
+  if (fileMode != Options::SCRATCH) {
+    if (hydFile == nullptr)
+      hydFile = new HydFile();
+    string fileName = network->option(Options::HYD_FILE_NAME);
+    int err = (fileMode == Options::SAVE)
+                  ? hydFile->openWriter(fileName, network)
+                  : hydFile->openReader(fileName, network);
+    if (err)
+      throw FileError(err);
+    saveToFile = (fileMode == Options::SAVE);
+    readFromFile = (fileMode == Options::USE);
+  }
 
   halted = 0;
   currentTime = 0;
@@ -133,6 +154,7 @@ void HydEngine::init(bool initFlows) {
   startTime = network->option(Options::START_TIME);
   rptTime = network->option(Options::REPORT_START);
   peakKwatts = 0.0;
+  deficientNodes = 0;
   engineState = HydEngine::INITIALIZED;
   timeStepReason = "";
 }
@@ -142,8 +164,24 @@ void HydEngine::init(bool initFlows) {
 //  Solves network hydraulics at the current point in time.
 
 int HydEngine::solve(int *t) {
-  if (engineState != HydEngine::INITIALIZED)
+  if (!beginSolve(t))
     return 0;
+
+  // if ( network->option(Options::REPORT_TRIALS) )  network->msgLog << endl;
+  int trials = 0;
+  int statusCode = hydSolver->solve(hydStep, trials);
+  return endSolve(statusCode, trials);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Update conditions at the current time before the network is solved.
+//  Returns false if the engine is not initialized or if the conditions
+//  are read from a hydraulics file instead.
+
+bool HydEngine::beginSolve(int *t) {
+  if (engineState != HydEngine::INITIALIZED)
+    return false;
   if (network->option(Options::REPORT_STATUS)) {
     network->msgLog << endl
                     << "  Hour " << Utilities::getTime(currentTime)
@@ -152,15 +190,23 @@ int HydEngine::solve(int *t) {
 
   *t = currentTime;
   timeOfDay = (currentTime + startTime) % 86400;
+  if (readFromFile) {
+    hydFile->readStep(t);
+    return false;
+  }
   updateCurrentConditions();
+  return true;
+}
 
-  // if ( network->option(Options::REPORT_TRIALS) )  network->msgLog << endl;
-  int trials = 0;
-  int statusCode = hydSolver->solve(hydStep, trials);
+//-----------------------------------------------------------------------------
 
-  if (statusCode == HydSolver::SUCCESSFUL && isPressureDeficient()) {
-    statusCode = resolvePressureDeficiency(trials);
-  }
+//  Complete the solution of the current time step once the hydraulic
+//  solver has returned statusCode after a number of trials.
+
+int HydEngine::endSolve(int statusCode, int trials) {
+  if (statusCode == HydSolver::SUCCESSFUL &&
+      network->demandModel->isPressureDriven())
+    countDeficientNodes();
   reportDiagnostics(statusCode, trials);
   if (halted)
     throw SystemError(SystemError::HYDRAULICS_SOLVER_FAILURE);
@@ -169,6 +215,41 @@ int HydEngine::solve(int *t) {
 
 //-----------------------------------------------------------------------------
 
+//  Run the hydraulic solvers of engines whose beginSolve() succeeded.
+//  The GGA solvers of engines with identical matrix structure are run in
+//  lockstep; any other solver runs on its own.
+
+void HydEngine::solveLanes(const vector<HydEngine *> &engines,
+                           vector<int> &statusCodes, vector<int> &trials) {
+  size_t engineCount = engines.size();
+  statusCodes.assign(engineCount, HydSolver::SUCCESSFUL);
+  trials.assign(engineCount, 0);
+
+  vector<GGASolver *> lanes;
+  vector<double> tsteps;
+  vector<size_t> laneEngines;
+  for (size_t e = 0; e < engineCount; e++) {
+    HydEngine *engine = engines[e];
+    GGASolver *gga = dynamic_cast<GGASolver *>(engine->hydSolver);
+    if (gga == nullptr) {
+      statusCodes[e] = engine->hydSolver->solve(engine->hydStep, trials[e]);
+      continue;
+    }
+    lanes.push_back(gga);
+    tsteps.push_back(engine->hydStep);
+    laneEngines.push_back(e);
+  }
+
+  vector<int> laneStatus, laneTrials;
+  GGASolver::solveLanes(lanes, tsteps, laneTrials, laneStatus);
+  for (size_t l = 0; l < lanes.size(); l++) {
+    statusCodes[laneEngines[l]] = laneStatus[l];
+    trials[laneEngines[l]] = laneTrials[l];
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Advances the simulation to the next point in time.
 
 void HydEngine::advance(int *tstep) {
@@ -176,26 +257,38 @@ void HydEngine::advance(int *tstep) {
   if (engineState != HydEngine::INITIALIZED)
     return;
 
-  // ... save current results to hydraulics file
-  // if ( saveToFile ) errcode = hydWriter.writeResults(hydState, hydTime);
-
   // ... if time remains, find time (hydStep) until next hydraulic event
+  //     (or read it and the tank volumes it ends with from file)
 
   hydStep = 0;
-  int timeLeft = network->option(Options::TOTAL_DURATION) - currentTime;
-  if (halted)
-    timeLeft = 0;
-  if (timeLeft > 0) {
-    hydStep = getTimeStep();
-    if (hydStep > timeLeft)
-      hydStep = timeLeft;
+  if (readFromFile)
+    hydFile->readAdvance(&hydStep, &peakKwatts);
+  else {
+    int timeLeft = network->option(Options::TOTAL_DURATION) - currentTime;
+    if (halted)
+      timeLeft = 0;
+    if (timeLeft > 0) {
+      hydStep = getTimeStep();
+      if (hydStep > timeLeft)
+        hydStep = timeLeft;
+    }
+
+    // ... update energy usage and tank levels over the time step
+
+    updateEnergyUsage();
+    updateTanks();
   }
   *tstep = hydStep;
 
-  // ... update energy usage and tank levels over the time step
+  // ... save current results to hydraulics file
 
-  updateEnergyUsage();
-  updateTanks();
+  if (saveToFile) {
+    int err = hydFile->writeStep(currentTime, hydStep, peakKwatts);
+    if (err == 0 && hydStep == 0)
+      err = hydFile->closeWriter();
+    if (err)
+      throw FileError(err);
+  }
 
   // ... advance time counters
 
@@ -220,6 +313,8 @@ void HydEngine::close() {
   matrixSolver = nullptr;
   delete hydSolver;
   hydSolver = nullptr;
+  delete hydFile;
+  hydFile = nullptr;
   engineState = HydEngine::CLOSED;
 
   //... Other objects created in HydEngine::open() belong to the
@@ -231,22 +326,28 @@ void HydEngine::close() {
 //  Initializes the matrix equation solver.
 
 void HydEngine::initMatrixSolver() {
-  int nodeCount = network->count(Element::NODE);
-  int linkCount = network->count(Element::LINK);
   try {
-    // ... place the start/end node indexes of each network link in arrays
+    // ... peel the tree branches off the network; only the looped core
+    //     of nodes and links enters the matrix solver
+
+    Graph &graph = network->graph;
+    graph.findForestCore(network);
+    int nodeCount = graph.coreNodeCount();
+    int linkCount = graph.coreLinkCount();
+
+    // ... place the start/end core node indexes of each core link in arrays
 
     vector<int> node1(linkCount);
     vector<int> node2(linkCount);
     for (int k = 0; k < linkCount; k++) {
-      node1[k] = network->link(k)->fromNode->index;
-      node2[k] = network->link(k)->toNode->index;
+      Link *link = network->link(graph.coreLinks[k]);
+      node1[k] = graph.coreNodeIndex[link->fromNode->index];
+      node2[k] = graph.coreNodeIndex[link->toNode->index];
     }
 
     // ...  initialize the matrix solver
 
-    matrixSolver->init(nodeCount, linkCount, (int *)&node1[0],
-                       (int *)&node2[0]);
+    matrixSolver->init(nodeCount, linkCount, node1.data(), node2.data());
   } catch (...) {
     throw;
   }
@@ -257,24 +358,13 @@ void HydEngine::initMatrixSolver() {
 //  Updates network conditions at start of current time step.
 
 void HydEngine::updateCurrentConditions() {
-  // ... identify global demand multiplier and pattern factor
-
-  double multiplier = network->option(Options::DEMAND_MULTIPLIER);
-  double patternFactor = 1.0;
-
-  ////  Need to change from a pattern index to a patttern pointer  /////
-  ////  or to update DEMAND_PATTERN option if current pattern is deleted.  ////
+  // ... find junctions' full target demands for current time period
 
-  int p = network->option(Options::DEMAND_PATTERN);
-  if (p >= 0)
-    patternFactor = network->pattern(p)->currentFactor();
+  demandTimeline.update(network, currentTime);
 
   // ... update node conditions
 
   for (Node *node : network->nodes) {
-    // ... find node's full target demand for current time period
-    node->findFullDemand(multiplier, patternFactor);
-
     // ... set its fixed grade state (for tanks & reservoirs)
     node->setFixedGrade();
   }
@@ -291,90 +381,23 @@ void HydEngine::updateCurrentConditions() {
 
   // ... apply simple conditional controls
 
-  for (Control *control : network->controls) {
-    control->apply(network, currentTime, timeOfDay);
-  }
+  network->controlProgram.apply(network, currentTime, timeOfDay);
 }
 
 //-----------------------------------------------------------------------------
 
-bool HydEngine::isPressureDeficient() {
-  int count = 0;
-  for (Node *node : network->nodes) {
-    // ... This only gets evaluated for the CONSTRAINED demand model
-    if (node->isPressureDeficient(network))
-      count++;
-  }
-  if (count > 0 && network->option(Options::REPORT_TRIALS)) {
-    network->msgLog << "\n\n    " << count << s_Deficient;
-  }
-  return (count > 0);
-}
-
-//-----------------------------------------------------------------------------
-
-int HydEngine::resolvePressureDeficiency(int &trials) {
-  int trials2 = 0;
-  int trials3 = 0;
-  int trials4 = 0;
-  int count1 = 0;
-  int count2 = 0;
-  bool reportTrials = (network->option(Options::REPORT_TRIALS));
-
-  // ... re-solve network hydraulics with the pressure deficient junctions
-  //     set to fixed grade (which occurred in isPressureDeficient())
-
-  if (reportTrials)
-    network->msgLog << s_ReSolve1;
-  int statusCode = hydSolver->solve(hydStep, trials2);
-  if (statusCode == HydSolver::FAILED_ILL_CONDITIONED)
-    return statusCode;
-
-  // ... adjust actual demands for the pressure deficient junctions
+//  Count the junctions whose demand was reduced for lack of pressure (the
+//  demand model's demand-pressure curve is part of the hydraulic solution).
 
+void HydEngine::countDeficientNodes() {
+  deficientNodes = 0;
   for (Node *node : network->nodes) {
-    if (node->type() == Node::JUNCTION && node->fixedGrade) {
-      node->actualDemand = min(node->actualDemand, node->fullDemand);
-      node->actualDemand = max(0.0, node->actualDemand);
-      if (node->actualDemand < node->fullDemand)
-        count1++;
-      node->fixedGrade = false;
-    }
-  }
-
-  // ... re-solve once more with the reduced demands at the affected junctions
-
-  if (reportTrials) {
-    network->msgLog << "\n\n    " << count1 << s_Reductions1;
-    network->msgLog << s_ReSolve2;
-  }
-  statusCode = hydSolver->solve(hydStep, trials3);
-
-  // ... check once more for any remaining pressure deficiencies
-
-  for (Node *node : network->nodes) {
-    if (node->isPressureDeficient(network)) {
-      count2++;
-
-      // ... remove fixed grade status set in isPressureDeficient
-      //     and make actual demand 0
-      node->fixedGrade = false;
-      node->actualDemand = 0.0;
-    }
+    if (node->isPressureDeficient(network))
+      deficientNodes++;
   }
-
-  // ... if there are any, then re-solve once more
-
-  if (count2 > 0) {
-    if (reportTrials) {
-      network->msgLog << "\n    " << count2 << s_Reductions2;
-      network->msgLog << s_ReSolve2 << "\n";
-    }
-    statusCode = hydSolver->solve(hydStep, trials4);
+  if (deficientNodes > 0 && network->option(Options::REPORT_TRIALS)) {
+    network->msgLog << "\n\n    " << deficientNodes << s_Deficient;
   }
-
-  trials += trials2 + trials3 + trials4;
-  return statusCode;
 }
 
 //-----------------------------------------------------------------------------
@@ -450,13 +473,8 @@ int HydEngine::getTimeStep() {
 
 int HydEngine::timeToPatternChange(int tstep) {
   Pattern *changedPattern = nullptr;
-  for (Pattern *pattern : network->patterns) {
-    int t = pattern->nextTime(currentTime) - currentTime;
-    if (t > 0 && t < tstep) {
-      tstep = t;
-      changedPattern = pattern;
-    }
-  }
+  tstep = eventQueue.timeToPatternChange(network, currentTime, tstep,
+                                         changedPattern);
   if (changedPattern) {
     timeStepReason = "  (change in Pattern " + changedPattern->name + ")";
   }
@@ -469,25 +487,7 @@ int HydEngine::timeToPatternChange(int tstep) {
 
 int HydEngine::timeToCloseTank(int tstep) {
   Tank *closedTank = nullptr;
-  for (Node *node : network->nodes) {
-    // ... check if node is a tank
-
-    if (node->type() == Node::TANK) {
-      // ... find the time to fill (or empty) the tank
-
-      Tank *tank = static_cast<Tank *>(node);
-      int t = tank->timeToVolume(tank->minVolume);
-      if (t <= 0)
-        t = tank->timeToVolume(tank->maxVolume);
-
-      // ... compare this time with current time step
-
-      if (t > 0 && t < tstep) {
-        tstep = t;
-        closedTank = tank;
-      }
-    }
-  }
+  tstep = eventQueue.timeToCloseTank(tstep, closedTank);
   if (closedTank) {
     timeStepReason = "  (Tank " + closedTank->name + " closed)";
   }
@@ -500,13 +500,8 @@ int HydEngine::timeToCloseTank(int tstep) {
 
 int HydEngine::timeToActivateControl(int tstep) {
   bool activated = false;
-  for (Control *control : network->controls) {
-    int t = control->timeToActivate(network, currentTime, timeOfDay);
-    if (t > 0 && t < tstep) {
-      tstep = t;
-      activated = true;
-    }
-  }
+  tstep = eventQueue.timeToActivateControl(network, currentTime, timeOfDay,
+                                           tstep, activated);
   if (activated)
     timeStepReason = "  (control activated)";
   return tstep;
@@ -11,10 +11,15 @@
 #ifndef HYDENGINE_H_
 #define HYDENGINE_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 class Network;
+class HydFile;
 
+#include "Core/demandtimeline.h"
+#include "Core/eventqueue.h"
 #include "Solvers/hydsolver.h"
 #include "Solvers/matrixsolver.h"
 
@@ -51,10 +56,31 @@ public:
   void init(bool initFlows);
   int solve(int *t);
   void advance(int *tstep);
+
+  // Solution of a time step in phases, so that the hydraulic solvers of
+  // several engines can run in lockstep between them (see solveLanes)
+  bool beginSolve(int *t);
+  int endSolve(int statusCode, int trials);
+  static void solveLanes(const std::vector<HydEngine *> &engines,
+                         std::vector<int> &statusCodes,
+                         std::vector<int> &trials);
   void close();
 
+  // Symbolic factorization shared with the engines of other projects that
+  // load the same network; must be set before open()
+  void shareSymbolicFactor(std::shared_ptr<SymbolicFactor> cache) {
+    symbolicFactor = cache;
+  }
+
+  // Demand table shared with the engines of other projects that load the
+  // same network; must be set before init()
+  void shareDemandTable(std::shared_ptr<DemandTableCache> cache) {
+    demandTimeline.shareTable(cache);
+  }
+
   int getElapsedTime() { return currentTime; }
   double getPeakKwatts() { return peakKwatts; }
+  int getDeficientNodeCount() { return deficientNodes; }
 
   //! Serialize to JSON for HydEngine
   nlohmann::json to_json() const {
@@ -119,11 +145,15 @@ private:
   Network *network;           //!< network being analyzed
   HydSolver *hydSolver;       //!< steady state hydraulic solver
   MatrixSolver *matrixSolver; //!< sparse matrix solver
-  //    HydFile*       hydFile;            //!< hydraulics file accessor
+  DemandTimeline demandTimeline; //!< junction demands at each time step
+  EventQueue eventQueue;      //!< pending pattern and control events
+  HydFile *hydFile;           //!< hydraulics file accessor
+  std::shared_ptr<SymbolicFactor> symbolicFactor; //!< shared by solvers
 
   // Engine properties
 
   bool saveToFile;            //!< true if results saved to file
+  bool readFromFile;          //!< true if results read from file
   bool halted;                //!< true if simulation has been halted
   int startTime;              //!< starting time of day (sec)
   int rptTime;                //!< current reporting time (sec)
@@ -131,6 +161,7 @@ private:
   int currentTime;            //!< current simulation time (sec)
   int timeOfDay;              //!< current time of day (sec)
   double peakKwatts;          //!< peak energy usage (kwatts)
+  int deficientNodes;         //!< junctions short of demand at last solution
   std::string timeStepReason; //!< reason for taking next time step
 
   // Simulation sub-tasks
@@ -147,8 +178,7 @@ private:
   void updatePatterns();
   void updateEnergyUsage();
 
-  bool isPressureDeficient();
-  int resolvePressureDeficiency(int &trials);
+  void countDeficientNodes();
   void reportDiagnostics(int statusCode, int trials);
 };
 
@@ -71,6 +71,7 @@ void Network::clear() {
   for (Control *control : controls)
     control->~Control();
   controls.clear();
+  controlProgram.clear();
 
   // ... reclaim all memory allocated by the memory pool
 
@@ -246,6 +247,38 @@ bool Network::addElement(Element::ElementType element, int type, string name) {
 
 //-----------------------------------------------------------------------------
 
+void Network::removeElements(const vector<char> &nodeFlags,
+                             const vector<char> &linkFlags) {
+  // Note: the caller must insure that no remaining element refers to a
+  //       removed one.
+
+  vector<Link *> keptLinks;
+  for (Link *link : links) {
+    if (linkFlags[link->index]) {
+      linkTable.erase(link->name);
+      link->~Link();
+    } else {
+      link->index = keptLinks.size();
+      keptLinks.push_back(link);
+    }
+  }
+  links.swap(keptLinks);
+
+  vector<Node *> keptNodes;
+  for (Node *node : nodes) {
+    if (nodeFlags[node->index]) {
+      nodeTable.erase(node->name);
+      node->~Node();
+    } else {
+      node->index = keptNodes.size();
+      keptNodes.push_back(node);
+    }
+  }
+  nodes.swap(keptNodes);
+}
+
+//-----------------------------------------------------------------------------
+
 bool Network::createHeadLossModel() {
   if (headLossModel)
     delete headLossModel;
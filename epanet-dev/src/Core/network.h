@@ -12,6 +12,7 @@
 #ifndef NETWORK_H_
 #define NETWORK_H_
 
+#include "Core/controlprogram.h"
 #include "Core/options.h"
 #include "Core/qualbalance.h"
 #include "Core/units.h"
@@ -57,6 +58,10 @@ public:
   // Adds an element to the network
   bool addElement(Element::ElementType eType, int subType, std::string name);
 
+  // Removes the flagged nodes and links and re-indexes the others
+  void removeElements(const std::vector<char> &nodeFlags,
+                      const std::vector<char> &linkFlags);
+
   // Finds element counts by type and index by id name
   int count(Element::ElementType eType);
   int indexOf(Element::ElementType eType, const std::string &name);
@@ -106,6 +111,7 @@ public:
   std::vector<Curve *> curves;     //!< collection of data curve objects
   std::vector<Pattern *> patterns; //!< collection of time pattern objects
   std::vector<Control *> controls; //!< collection of control rules
+  ControlProgram controlProgram;   //!< controls compiled for evaluation
   Units units;                     //!< unit conversion factors
   Options options;                 //!< analysis options
   QualBalance qualBalance;         //!< water quality mass balance
@@ -38,7 +38,17 @@ static const char *pressureUnitsWords[] = {"PSI", "METERS", "PKA", 0};
 static const char *headlossModelWords[] = {"H-W", "D-W", "C-M", 0};
 
 // Hydraulic Newton solver step size method names
-static const char *stepSizingWords[] = {"FULL", "RELAXATION", "LINESEARCH", 0};
+static const char *stepSizingWords[] = {"FULL", "RELAXATION", "LINESEARCH",
+                                        "ANDERSON", 0};
+
+// Sparse matrix solver names
+static const char *matrixSolverWords[] = {"SPARSPAK", "PCG", 0};
+
+// Sparse matrix row ordering names
+static const char *matrixOrderingWords[] = {"MMD", "ND", 0};
+
+// Sparse matrix factor precision names
+static const char *matrixPrecisionWords[] = {"DOUBLE", "MIXED", 0};
 
 static const char *ifUnbalancedWords[] = {"STOP", "CONTINUE", 0};
 
@@ -56,8 +66,7 @@ static const char *qualModelWords[] = {"NONE", "AGE", "TRACE", "CHEMICAL", 0};
 static const char *qualUnitsWords[] = {"", "HRS", "PCNT", "MG/L", "UG/L", 0};
 
 // File mode keywords
-// static const char* w_Use  = "USE";
-// static const char* w_Save = "SAVE";
+static const char *fileModeWords[] = {"SCRATCH", "USE", "SAVE", 0};
 
 //-----------------------------------------------------------------------------
 
@@ -77,6 +86,8 @@ void Options::setDefaults() {
   stringOptions[HYD_SOLVER] = "GGA";
   stringOptions[STEP_SIZING] = "FULL";
   stringOptions[MATRIX_SOLVER] = "SPARSPAK";
+  stringOptions[MATRIX_ORDERING] = "MMD";
+  stringOptions[MATRIX_PRECISION] = "DOUBLE";
   stringOptions[DEMAND_PATTERN_NAME] = "";
   stringOptions[QUAL_MODEL] = "NONE";
   stringOptions[QUAL_NAME] = "Chemical";
@@ -94,6 +105,8 @@ void Options::setDefaults() {
   indexOptions[QUAL_TYPE] = NOQUAL;
   indexOptions[QUAL_UNITS] = MGL;
   indexOptions[TRACE_NODE] = -1;
+  indexOptions[MAX_SEGMENTS] = 0;
+  indexOptions[PARALLEL_ROWS] = 0;
 
   indexOptions[REPORT_SUMMARY] = true;
   indexOptions[REPORT_ENERGY] = false;
@@ -121,6 +134,7 @@ void Options::setDefaults() {
   valueOptions[KIN_VISCOSITY] = VISCOSITY;
   valueOptions[MOLEC_DIFFUSIVITY] = DIFFUSIVITY;
   valueOptions[QUAL_TOLERANCE] = 0.01;
+  valueOptions[COURANT_NUMBER] = 0.0;
   valueOptions[BULK_ORDER] = 1.0;
   valueOptions[WALL_ORDER] = 1.0;
   valueOptions[TANK_ORDER] = 1.0;
@@ -150,6 +164,10 @@ void Options::setDefaults() {
 int Options::setOption(StringOption option, const string &value) {
   int i;
   switch (option) {
+  case HYD_FILE_NAME:
+    stringOptions[HYD_FILE_NAME] = value;
+    break;
+
   case HEADLOSS_MODEL:
     i = Utilities::findFullMatch(value, headlossModelWords);
     if (i < 0)
@@ -164,6 +182,27 @@ int Options::setOption(StringOption option, const string &value) {
     stringOptions[STEP_SIZING] = stepSizingWords[i];
     break;
 
+  case MATRIX_SOLVER:
+    i = Utilities::findFullMatch(value, matrixSolverWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[MATRIX_SOLVER] = matrixSolverWords[i];
+    break;
+
+  case MATRIX_ORDERING:
+    i = Utilities::findFullMatch(value, matrixOrderingWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[MATRIX_ORDERING] = matrixOrderingWords[i];
+    break;
+
+  case MATRIX_PRECISION:
+    i = Utilities::findFullMatch(value, matrixPrecisionWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[MATRIX_PRECISION] = matrixPrecisionWords[i];
+    break;
+
   case DEMAND_MODEL:
     i = Utilities::findFullMatch(value, demandModelWords);
     if (i < 0)
@@ -258,6 +297,10 @@ int Options::setOption(IndexOption option, const string &value,
     break;
 
   case HYD_FILE_MODE:
+    i = Utilities::findFullMatch(ucValue, fileModeWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    indexOptions[HYD_FILE_MODE] = i;
     break;
 
   case DEMAND_PATTERN:
@@ -276,6 +319,20 @@ int Options::setOption(IndexOption option, const string &value,
     stringOptions[TRACE_NODE_NAME] = value;
     break;
 
+  case MAX_SEGMENTS:
+    i = atoi(value.c_str());
+    if (i < 0)
+      return InputError::INVALID_NUMBER;
+    indexOptions[MAX_SEGMENTS] = i;
+    break;
+
+  case PARALLEL_ROWS:
+    i = atoi(value.c_str());
+    if (i < 0)
+      return InputError::INVALID_NUMBER;
+    indexOptions[PARALLEL_ROWS] = i;
+    break;
+
   default:
     break;
   }
@@ -363,6 +420,10 @@ string Options::hydOptionsToStr() {
   s << valueOptions[TIME_WEIGHT] << "\n";
   s << setw(w) << "STEP_SIZING";
   s << stringOptions[STEP_SIZING] << "\n";
+  if (indexOptions[PARALLEL_ROWS] > 0) {
+    s << setw(w) << "MATRIX_PARALLEL_ROWS";
+    s << indexOptions[PARALLEL_ROWS] << "\n";
+  }
   s << setw(w) << "IF_UNBALANCED";
   s << ifUnbalancedWords[indexOptions[IF_UNBALANCED]] << "\n\n";
   return s.str();
@@ -423,6 +484,14 @@ string Options::qualOptionsToStr() {
   s << valueOptions[MOLEC_DIFFUSIVITY] / DIFFUSIVITY << "\n";
   s << setw(w) << "QUALITY_TOLERANCE";
   s << valueOptions[QUAL_TOLERANCE] << "\n";
+  if (valueOptions[COURANT_NUMBER] > 0.0) {
+    s << setw(w) << "COURANT_NUMBER";
+    s << valueOptions[COURANT_NUMBER] << "\n";
+  }
+  if (indexOptions[MAX_SEGMENTS] > 0) {
+    s << setw(w) << "MAXIMUM_SEGMENTS";
+    s << indexOptions[MAX_SEGMENTS] << "\n";
+  }
   return s.str();
 }
 
@@ -49,6 +49,8 @@ public:
     HYD_SOLVER,          //!< Name of hydraulic solver method
     STEP_SIZING,         //!< Name of Newton step size method
     MATRIX_SOLVER,       //!< Name of sparse matrix eqn. solver
+    MATRIX_ORDERING,     //!< Name of sparse matrix row ordering method
+    MATRIX_PRECISION,    //!< Name of sparse matrix factor precision
     DEMAND_PATTERN_NAME, //!< Name of global demand pattern
 
     QUAL_MODEL,      //!< Name of water quality model used
@@ -74,6 +76,8 @@ public:
     QUAL_TYPE,  //!< Type of water quality analysis
     QUAL_UNITS, //!< Units of the quality constituent
     TRACE_NODE, //!< Node index for source tracing
+    MAX_SEGMENTS, //!< Maximum volume segments per link (0 = no limit)
+    PARALLEL_ROWS, //!< Rows, links or nodes needed to use threads (0 = default)
 
     REPORT_SUMMARY, //!< report input/output summary
     REPORT_ENERGY,  //!< report energy usage
@@ -110,6 +114,7 @@ public:
     // Water quality options
     MOLEC_DIFFUSIVITY, //!< Chemical's molecular diffusivity (ft2/sec)
     QUAL_TOLERANCE,    //!< Tolerance for water quality comparisons
+    COURANT_NUMBER,    //!< Max. pipe Courant number of adaptive quality steps
     BULK_ORDER,        //!< Order of all bulk flow reactions in pipes
     WALL_ORDER,        //!< Order of all pipe wall reactions
     TANK_ORDER,        //!< Order of all bulk water reactions in tanks
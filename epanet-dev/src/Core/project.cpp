@@ -12,6 +12,7 @@
 #include "project.h"
 #include "Core/diagnostics.h"
 #include "Core/error.h"
+#include "Elements/pattern.h"
 #include "Input/inputreader.h"
 #include "Output/projectwriter.h"
 #include "Output/reportwriter.h"
@@ -28,7 +29,8 @@ namespace Epanet {
 
 Project::Project()
     : inpFileName(""), networkEmpty(true), hydEngineOpened(false),
-      qualEngineOpened(false), solverInitialized(false), runQuality(false) {}
+      qualEngineOpened(false), solverInitialized(false), runQuality(false),
+      loadedStateSaved(false) {}
 
 //  Destructor
 
@@ -68,6 +70,26 @@ int Project::load(const char *fname) {
 
 //-----------------------------------------------------------------------------
 
+//  Remove network elements that don't change the hydraulic solution.
+
+//  Must be called after the project is loaded and before its solver is
+//  initialized; the named nodes and links are always kept.
+
+int Project::skeletonize(const set<string> &keepNodes,
+                         const set<string> &keepLinks) {
+  try {
+    if (networkEmpty || hydEngineOpened)
+      return 0;
+    skeletonizer.reduce(&network, keepNodes, keepLinks);
+    return 0;
+  } catch (ENerror const &e) {
+    writeMsg(e.msg);
+    return e.code;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Save the project to a file.
 
 int Project::save(const char *fname) {
@@ -96,9 +118,13 @@ void Project::clear() {
 
   network.clear();
   networkEmpty = true;
+  skeletonizer.clear();
 
   solverInitialized = false;
   inpFileName = "";
+
+  loadedFactors.clear();
+  loadedStateSaved = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -142,6 +168,58 @@ int Project::initSolver(bool initFlows) {
 
 //-----------------------------------------------------------------------------
 
+//  Record the current state of an initialized project as the one to which
+//  reset() returns it.
+
+int Project::saveLoadedState() {
+  try {
+    if (!solverInitialized)
+      throw SystemError(SystemError::SOLVER_NOT_INITIALIZED);
+
+    // ... only the factors of fixed patterns can be changed once loaded
+    loadedFactors.assign(network.count(Element::PATTERN), vector<double>());
+    for (size_t i = 0; i < loadedFactors.size(); i++) {
+      Pattern *pattern = network.pattern(i);
+      if (pattern->type != Pattern::FIXED_PATTERN)
+        continue;
+      for (int j = 0; j < pattern->size(); j++)
+        loadedFactors[i].push_back(pattern->factor(j));
+    }
+    copy_to(loadedState);
+    loadedStateSaved = true;
+    return 0;
+  } catch (ENerror const &e) {
+    writeMsg(e.msg);
+    return e.code;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Return the project to the state recorded by saveLoadedState(), undoing
+//  the changes made to its pattern factors and the simulation run since.
+
+int Project::reset() {
+  try {
+    if (!loadedStateSaved)
+      throw SystemError(SystemError::SOLVER_NOT_INITIALIZED);
+    for (size_t i = 0; i < loadedFactors.size(); i++) {
+      FixedPattern *pattern = static_cast<FixedPattern *>(network.pattern(i));
+      for (size_t j = 0; j < loadedFactors[i].size(); j++)
+        pattern->setFactor(j, loadedFactors[i][j]);
+    }
+  } catch (ENerror const &e) {
+    writeMsg(e.msg);
+    return e.code;
+  }
+  int err = initSolver(true);
+  if (err == 0)
+    copy_from(loadedState);
+  return err;
+}
+
+//-----------------------------------------------------------------------------
+
 //  Solve network hydraulics at the current point in time.
 
 int Project::runSolver(int *t) {
@@ -158,6 +236,48 @@ int Project::runSolver(int *t) {
 
 //-----------------------------------------------------------------------------
 
+void Project::runSolverLanes(const vector<Project *> &projects, vector<int> &t,
+                             vector<int> &codes) {
+  size_t count = projects.size();
+  t.resize(count, 0);
+  codes.assign(count, 0);
+
+  // ... update the conditions of each project at its current time
+
+  vector<HydEngine *> engines;
+  vector<size_t> index;
+  for (size_t i = 0; i < count; i++) {
+    Project *p = projects[i];
+    try {
+      if (!p->solverInitialized)
+        throw SystemError(SystemError::SOLVER_NOT_INITIALIZED);
+      if (p->hydEngine.beginSolve(&t[i])) {
+        engines.push_back(&p->hydEngine);
+        index.push_back(i);
+      }
+    } catch (ENerror const &e) {
+      p->writeMsg(e.msg);
+      codes[i] = e.code;
+    }
+  }
+
+  // ... solve the networks together and complete each solution
+
+  vector<int> statusCodes, trials;
+  HydEngine::solveLanes(engines, statusCodes, trials);
+  for (size_t k = 0; k < engines.size(); k++) {
+    Project *p = projects[index[k]];
+    try {
+      codes[index[k]] = engines[k]->endSolve(statusCodes[k], trials[k]);
+    } catch (ENerror const &e) {
+      p->writeMsg(e.msg);
+      codes[index[k]] = e.code;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Advance the hydraulic solver to the next point in time while updating
 //  water quality.
 
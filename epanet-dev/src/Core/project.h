@@ -25,10 +25,12 @@
 #include "Core/hydengine.h"
 #include "Core/network.h"
 #include "Core/qualengine.h"
+#include "Core/skeletonizer.h"
 #include "Output/outputfile.h"
 #include "Utilities/utilities.h"
 
 #include <fstream>
+#include <set>
 #include <string>
 
 class ProjectData {
@@ -57,10 +59,25 @@ public:
   int save(const char *fname);
   void clear();
 
+  int skeletonize(const std::set<std::string> &keepNodes,
+                  const std::set<std::string> &keepLinks);
+
   int initSolver(bool initFlows);
   int runSolver(int *t);
   int advanceSolver(int *dt);
 
+  // Records the state of an initialized project (its pattern factors and
+  // the state of its network and hydraulic engine) for reset() to return
+  // it to, so that it can be simulated again without being reloaded
+  int saveLoadedState();
+  int reset();
+
+  // Runs the hydraulic solvers of several projects loaded from the same
+  // network in lockstep (t[i] and the returned codes[i] are those that
+  // runSolver() would give for project i)
+  static void runSolverLanes(const std::vector<Project *> &projects,
+                             std::vector<int> &t, std::vector<int> &codes);
+
   int openOutput(const char *fname);
   int saveOutput();
 
@@ -74,6 +91,22 @@ public:
   void writeMsgLog();
   Network *getNetwork() { return &network; }
 
+  // Shares the symbolic factorization of the hydraulic matrix with other
+  // projects loading the same network (call before initSolver())
+  void shareSymbolicFactor(std::shared_ptr<SymbolicFactor> cache) {
+    hydEngine.shareSymbolicFactor(cache);
+  }
+
+  // Shares the tabulated junction demands with other projects loading the
+  // same network (call before initSolver())
+  void shareDemandTable(std::shared_ptr<DemandTableCache> cache) {
+    hydEngine.shareDemandTable(cache);
+  }
+  Skeletonizer *getSkeletonizer() { return &skeletonizer; }
+  void getSegmentStats(int &liveSegs, int &freeSegs, double &bytes) {
+    qualEngine.getSegmentStats(liveSegs, freeSegs, bytes);
+  }
+
   //! Serialize to JSON
   nlohmann::json to_json() const {
     return {{"network", network.to_json()}, {"hydEngine", hydEngine.to_json()}};
@@ -99,7 +132,11 @@ private:
   Network network;         //!< pipe network to be analyzed.
   HydEngine hydEngine;     //!< hydraulic simulation engine.
   QualEngine qualEngine;   //!< water quality simulation engine.
+  Skeletonizer skeletonizer; //!< maps results back to the full network.
   std::string inpFileName; //!< name of project's input file.
+  ProjectData loadedState; //!< state restored by reset().
+  std::vector<std::vector<double>> loadedFactors; //!< pattern factors
+                                                  //!< restored by reset().
 
   // Project status conditions
   bool networkEmpty;
@@ -107,6 +144,7 @@ private:
   bool qualEngineOpened;
   bool solverInitialized;
   bool runQuality;
+  bool loadedStateSaved;
 
   void finalizeSolver();
   void closeReport();
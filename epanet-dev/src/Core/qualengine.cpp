@@ -15,6 +15,7 @@
 
 #include "qualengine.h"
 #include "Elements/link.h"
+#include "Elements/pipe.h"
 #include "Elements/qualsource.h"
 #include "Elements/tank.h" // includes node.h
 #include "Models/qualmodel.h"
@@ -33,7 +34,8 @@ using namespace std;
 
 QualEngine::QualEngine()
     : engineState(QualEngine::CLOSED), network(nullptr), qualSolver(nullptr),
-      nodeCount(0), linkCount(0), qualTime(0), qualStep(0) {}
+      nodeCount(0), linkCount(0), qualTime(0), qualStep(0), maxCourant(0.0),
+      cTol(0.0) {}
 
 //-----------------------------------------------------------------------------
 
@@ -117,6 +119,8 @@ void QualEngine::init() {
   qualStep = network->option(Options::QUAL_STEP);
   if (qualStep <= 0)
     qualStep = 300;
+  maxCourant = network->option(Options::COURANT_NUMBER);
+  cTol = network->option(Options::QUAL_TOLERANCE) / network->ucf(Units::CONCEN);
   qualTime = 0;
   engineState = QualEngine::INITIALIZED;
 }
@@ -149,11 +153,79 @@ void QualEngine::solve(int tstep) {
 
   qualTime += tstep;
 
+  int qstep = findQualStep(tstep);
+  int steps = (tstep + qstep - 1) / qstep;
   while (tstep > 0) {
-    int qstep = min(qualStep, tstep);
+    // ... adaptive steps split what remains of the period evenly
+    if (maxCourant > 0.0)
+      qstep = tstep / steps--;
+    qstep = min(qstep, tstep);
     qualSolver->solve(&sortedLinks[0], qstep);
     tstep -= qstep;
   }
+
+  // ... merge similar volume segments once per hydraulic time step
+
+  qualSolver->compact();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the longest quality time step (sec) that satisfies the Courant
+//  number and reaction limits over a hydraulic period of tstep sec.
+
+int QualEngine::findQualStep(int tstep) {
+  if (maxCourant <= 0.0 || tstep <= qualStep)
+    return qualStep;
+
+  // ... limit the Courant number of the pipe with the shortest travel time
+  //     (pipes crossed within a fixed quality step are not limited)
+
+  double h = tstep;
+  for (Link *link : network->links) {
+    double q = abs(link->flow);
+    double v = link->getVolume();
+    if (q > 0.0 && v >= q * qualStep)
+      h = min(h, maxCourant * v / q);
+  }
+
+  // ... limit the concentration change of the fastest reaction
+
+  QualModel *qualModel = network->qualModel;
+  if (qualModel->type == QualModel::CHEM && qualModel->isReactive()) {
+    double rate = 0.0;
+    for (Link *link : network->links) {
+      if (link->type() != Link::PIPE)
+        continue;
+      Pipe *pipe = static_cast<Pipe *>(link);
+      qualModel->findMassTransCoeff(pipe);
+      double c = link->quality;
+      rate = max(rate, abs(qualModel->pipeReact(pipe, c, 1.0) - c));
+    }
+    for (Node *node : network->nodes) {
+      if (node->type() != Node::TANK)
+        continue;
+      Tank *tank = static_cast<Tank *>(node);
+      double c = tank->quality;
+      rate = max(rate, abs(qualModel->tankReact(tank, c, 1.0) - c));
+    }
+    if (rate > 0.0)
+      h = min(h, cTol / rate);
+  }
+  return max(qualStep, (int)h);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the number of volume segments in use and free and the memory
+//  (bytes) they occupy.
+
+void QualEngine::getSegmentStats(int &liveSegs, int &freeSegs, double &bytes) {
+  liveSegs = 0;
+  freeSegs = 0;
+  bytes = 0.0;
+  if (qualSolver)
+    qualSolver->getSegmentStats(liveSegs, freeSegs, bytes);
 }
 
 //-----------------------------------------------------------------------------
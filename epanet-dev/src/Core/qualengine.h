@@ -26,6 +26,14 @@ class QualSolver;
 //! The QualEngine class carries out an extended period water quality simulation
 //! on a pipe network, calling on its QualSolver object to solve the reaction,
 //! transport and mixing equations at each time step.
+//!
+//! The quality time step is fixed unless a maximum Courant number is given.
+//! Each hydraulic period is then divided into the fewest equal steps that
+//! keep the Courant number (step / travel time) of every pipe not already
+//! crossed within one fixed step under that limit and the change that
+//! reactions make to any concentration over a step within the quality
+//! tolerance; the fixed quality time step is the smallest step used.
+//! Periods of low flow are thus crossed in a few long steps.
 
 class QualEngine {
 public:
@@ -40,6 +48,7 @@ public:
   void init();
   void solve(int tstep);
   void close();
+  void getSegmentStats(int &liveSegs, int &freeSegs, double &bytes);
 
   //! Serialize to JSON for QualEngine
   nlohmann::json to_json() const {
@@ -77,12 +86,15 @@ private:
   int linkCount;                   //!< number of network links
   int qualTime;                    //!< current simulation time (sec)
   int qualStep;                    //!< hydraulic time step (sec)
+  double maxCourant;               //!< max. Courant number (0 if fixed step)
+  double cTol;                     //!< quality tolerance (mass/ft3)
   std::vector<int> sortedLinks;    //!< topologically sorted links
   std::vector<char> flowDirection; //!< direction (+/-) of link flow
 
   // Simulation sub-tasks
 
   bool flowDirectionsChanged();
+  int findQualStep(int tstep);
   void setFlowDirections();
   void sortLinks();
   void setSourceQuality();
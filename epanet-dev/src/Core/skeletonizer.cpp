@@ -0,0 +1,404 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+/////////////////////////////////////////////////
+//  Implementation of the Skeletonizer class.  //
+/////////////////////////////////////////////////
+
+#include "skeletonizer.h"
+#include "Core/constants.h"
+#include "Core/network.h"
+#include "Elements/control.h"
+#include "Elements/junction.h"
+#include "Elements/link.h"
+#include "Elements/node.h"
+#include "Elements/pipe.h"
+#include "Models/headlossmodel.h"
+
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+// Constructor/Destructor
+
+Skeletonizer::Skeletonizer() : sameSection(false) {}
+
+Skeletonizer::~Skeletonizer() {}
+
+//-----------------------------------------------------------------------------
+
+void Skeletonizer::clear() {
+  chains.clear();
+  nodeRefs.clear();
+  linkRefs.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Removes dead branches and series junctions from a network.
+
+int Skeletonizer::reduce(Network *nw, const set<string> &keepNodes,
+                         const set<string> &keepLinks) {
+  clear();
+
+  // ... pipe volumes and node mixing matter to water quality
+
+  if (nw->option(Options::QUAL_TYPE) != Options::NOQUAL)
+    return 0;
+
+  // ... the D-W friction factor depends on the pipe's cross section, so
+  //     only identical pipes have additive resistances
+
+  sameSection = nw->option(Options::HEADLOSS_MODEL) == "D-W";
+  nw->createHeadLossModel();
+
+  markRemovable(nw, keepNodes, keepLinks);
+  pruneDeadEnds(nw);
+  mergeSeriesPipes(nw);
+
+  // ... map every removed element to the surviving element it depends on
+
+  for (auto &entry : chains) {
+    Chain &chain = entry.second;
+    for (size_t i = 0; i < chain.nodes.size(); i++) {
+      nodeRefs[chain.nodes[i]] = {entry.first, "", (int)i};
+    }
+    for (size_t i = 0; i < chain.segments.size(); i++) {
+      if (chain.segments[i].pipe != entry.first)
+        linkRefs[chain.segments[i].pipe] = {entry.first, "", (int)i};
+    }
+  }
+
+  nw->removeElements(nodeRemoved, linkRemoved);
+
+  adjLinks.clear();
+  nodeRemovable.clear();
+  linkPrunable.clear();
+  linkMergeable.clear();
+  nodeRemoved.clear();
+  linkRemoved.clear();
+  return removedNodes();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Identifies the junctions and pipes that can be removed.
+
+void Skeletonizer::markRemovable(Network *nw, const set<string> &keepNodes,
+                                 const set<string> &keepLinks) {
+  int nodeCount = nw->count(Element::NODE);
+  int linkCount = nw->count(Element::LINK);
+  adjLinks.assign(nodeCount, vector<Link *>());
+  nodeRemovable.assign(nodeCount, 0);
+  linkPrunable.assign(linkCount, 0);
+  linkMergeable.assign(linkCount, 0);
+  nodeRemoved.assign(nodeCount, 0);
+  linkRemoved.assign(linkCount, 0);
+
+  // ... elements referenced by controls are kept
+
+  vector<char> controlled(nodeCount + linkCount, 0);
+  for (Control *control : nw->controls) {
+    if (control->getNode())
+      controlled[control->getNode()->index] = 1;
+    if (control->getLink())
+      controlled[nodeCount + control->getLink()->index] = 1;
+  }
+
+  bool reportAllNodes = nw->option(Options::REPORT_NODES) == Options::ALL;
+  bool reportAllLinks = nw->option(Options::REPORT_LINKS) == Options::ALL;
+
+  // ... junctions without demands or emitters
+
+  for (Node *node : nw->nodes) {
+    if (node->type() != Node::JUNCTION)
+      continue;
+    if (controlled[node->index] || node->rptFlag || reportAllNodes)
+      continue;
+    if (keepNodes.count(node->name))
+      continue;
+
+    Junction *junc = static_cast<Junction *>(node);
+    if (junc->hasEmitter() || junc->primaryDemand.baseDemand != 0.0)
+      continue;
+    bool hasDemand = false;
+    for (Demand &demand : junc->demands) {
+      if (demand.baseDemand != 0.0)
+        hasDemand = true;
+    }
+    nodeRemovable[node->index] = !hasDemand;
+  }
+
+  // ... pipes without leakage
+
+  for (Link *link : nw->links) {
+    adjLinks[link->fromNode->index].push_back(link);
+    adjLinks[link->toNode->index].push_back(link);
+
+    if (link->type() != Link::PIPE)
+      continue;
+    if (controlled[nodeCount + link->index] || link->rptFlag || reportAllLinks)
+      continue;
+    if (keepLinks.count(link->name))
+      continue;
+
+    Pipe *pipe = static_cast<Pipe *>(link);
+    if (pipe->canLeak())
+      continue;
+    linkPrunable[link->index] = 1;
+
+    // ... merged pipes must be open, free of check valves and have a finite
+    //     resistance proportional to their length
+
+    if (pipe->initStatus != Link::LINK_OPEN || pipe->hasCheckValve)
+      continue;
+    if (pipe->length <= 0.0)
+      continue;
+    pipe->setResistance(nw);
+    if (pipe->resistance <= 0.0 || pipe->resistance >= HIGH_RESISTANCE)
+      continue;
+    linkMergeable[link->index] = 1;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Prunes dead-end branches of zero-demand junctions, leaf first.
+
+//  A dead-end pipe carries no flow, so its junction has the head of the
+//  node the pipe hangs from.
+
+int Skeletonizer::pruneDeadEnds(Network *nw) {
+  int count = 0;
+  vector<int> leaves;
+  for (Node *node : nw->nodes) {
+    if (nodeRemovable[node->index] && adjLinks[node->index].size() == 1)
+      leaves.push_back(node->index);
+  }
+
+  while (!leaves.empty()) {
+    int k = leaves.back();
+    leaves.pop_back();
+    if (nodeRemoved[k] || adjLinks[k].size() != 1)
+      continue;
+    Link *link = adjLinks[k][0];
+    if (!linkPrunable[link->index])
+      continue;
+
+    Node *node = nw->node(k);
+    Node *anchor = (link->fromNode == node) ? link->toNode : link->fromNode;
+    nodeRefs[node->name] = {"", anchor->name, 0};
+    linkRefs[link->name] = {"", "", -1};
+    nodeRemoved[k] = 1;
+    linkRemoved[link->index] = 1;
+    adjLinks[k].clear();
+
+    vector<Link *> &anchorLinks = adjLinks[anchor->index];
+    anchorLinks.erase(find(anchorLinks.begin(), anchorLinks.end(), link));
+    if (nodeRemovable[anchor->index] && anchorLinks.size() == 1)
+      leaves.push_back(anchor->index);
+    count++;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Checks if the two pipes joined at a junction can be merged.
+
+bool Skeletonizer::canMerge(Link *link1, Link *link2, Node *node) const {
+  if (link1 == link2)
+    return false;
+  if (!linkMergeable[link1->index] || !linkMergeable[link2->index])
+    return false;
+
+  // ... the merged pipe can't start and end at the same node
+
+  Node *end1 = (link1->fromNode == node) ? link1->toNode : link1->fromNode;
+  Node *end2 = (link2->fromNode == node) ? link2->toNode : link2->fromNode;
+  if (end1 == end2 || end1 == node || end2 == node)
+    return false;
+
+  if (sameSection) {
+    Pipe *pipe1 = static_cast<Pipe *>(link1);
+    Pipe *pipe2 = static_cast<Pipe *>(link2);
+    if (pipe1->diameter != pipe2->diameter ||
+        pipe1->roughness != pipe2->roughness)
+      return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Returns the chain of segments of a surviving pipe.
+
+Skeletonizer::Chain &Skeletonizer::findChain(Pipe *pipe) {
+  auto it = chains.find(pipe->name);
+  if (it != chains.end())
+    return it->second;
+
+  // ... an unmerged pipe is a chain of a single segment whose weight is
+  //     its friction resistance (or its length for identical D-W pipes)
+
+  Chain &chain = chains[pipe->name];
+  double weight = sameSection ? pipe->length : pipe->resistance;
+  chain.segments.push_back({pipe->name, 1, weight, pipe->lossFactor});
+  return chain;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Removes zero-demand junctions joining two pipes.
+
+//  The pipes carry the same flow, so their friction resistances and minor
+//  loss factors add up. The surviving pipe keeps its own cross section and
+//  orientation and takes the length that gives it the total resistance.
+
+int Skeletonizer::mergeSeriesPipes(Network *nw) {
+  int count = 0;
+  for (Node *node : nw->nodes) {
+    int k = node->index;
+    if (!nodeRemovable[k] || nodeRemoved[k] || adjLinks[k].size() != 2)
+      continue;
+    Link *link1 = adjLinks[k][0];
+    Link *link2 = adjLinks[k][1];
+    if (!canMerge(link1, link2, node))
+      continue;
+
+    Pipe *pipe1 = static_cast<Pipe *>(link1);
+    Pipe *pipe2 = static_cast<Pipe *>(link2);
+    Chain chain1 = findChain(pipe1);
+    Chain chain2 = findChain(pipe2);
+    chains.erase(pipe2->name);
+
+    // ... orient the absorbed chain like the surviving pipe
+
+    bool atEnd = (pipe1->toNode == node);
+    bool sameDirection = atEnd ? (pipe2->fromNode == node)
+                               : (pipe2->toNode == node);
+    if (!sameDirection) {
+      reverse(chain2.segments.begin(), chain2.segments.end());
+      reverse(chain2.nodes.begin(), chain2.nodes.end());
+      for (Segment &segment : chain2.segments)
+        segment.sign = -segment.sign;
+    }
+    Node *far = (pipe2->fromNode == node) ? pipe2->toNode : pipe2->fromNode;
+
+    Chain &chain = chains[pipe1->name];
+    Chain &head = atEnd ? chain1 : chain2;
+    Chain &tail = atEnd ? chain2 : chain1;
+    chain.segments = head.segments;
+    chain.segments.insert(chain.segments.end(), tail.segments.begin(),
+                          tail.segments.end());
+    chain.nodes = head.nodes;
+    chain.nodes.push_back(node->name);
+    chain.nodes.insert(chain.nodes.end(), tail.nodes.begin(), tail.nodes.end());
+
+    // ... give the surviving pipe the chain's resistance
+
+    double weight1 = 0.0;
+    for (Segment &segment : chain1.segments)
+      weight1 += segment.weight;
+    double weight = 0.0;
+    double lossFactor = 0.0;
+    for (Segment &segment : chain.segments) {
+      weight += segment.weight;
+      lossFactor += segment.lossFactor;
+    }
+    pipe1->length *= weight / weight1;
+    pipe1->lossFactor = lossFactor;
+    pipe1->lossCoeff = lossFactor * pow(pipe1->diameter, 4) / 0.02517;
+    if (atEnd)
+      pipe1->toNode = far;
+    else
+      pipe1->fromNode = far;
+
+    // ... update the connectivity
+
+    vector<Link *> &farLinks = adjLinks[far->index];
+    replace(farLinks.begin(), farLinks.end(), link2, link1);
+    adjLinks[k].clear();
+    nodeRemoved[k] = 1;
+    linkRemoved[pipe2->index] = 1;
+    count++;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Finds the head of a node of the full network (ft).
+
+//  A junction removed from a merged chain lies between the chain's end
+//  nodes: the friction loss up to it is its share of the chain's weight
+//  and its minor loss is that of the segments upstream of it.
+
+bool Skeletonizer::findHead(Network *nw, const string &nodeName,
+                            double &head) const {
+  int index = nw->indexOf(Element::NODE, nodeName);
+  if (index >= 0) {
+    head = nw->node(index)->head;
+    return true;
+  }
+
+  auto ref = nodeRefs.find(nodeName);
+  if (ref == nodeRefs.end())
+    return false;
+  if (ref->second.chain.empty())
+    return findHead(nw, ref->second.anchor, head);
+
+  const Chain &chain = chains.at(ref->second.chain);
+  Link *link = nw->link(nw->indexOf(Element::LINK, ref->second.chain));
+  double q = link->flow;
+  double qq = q * abs(q);
+
+  double weight = 0.0, lossFactor = 0.0;
+  double upWeight = 0.0, upLossFactor = 0.0;
+  for (size_t i = 0; i < chain.segments.size(); i++) {
+    weight += chain.segments[i].weight;
+    lossFactor += chain.segments[i].lossFactor;
+    if ((int)i == ref->second.position) {
+      upWeight = weight;
+      upLossFactor = lossFactor;
+    }
+  }
+
+  double h1 = link->fromNode->head;
+  double friction = h1 - link->toNode->head - lossFactor * qq;
+  head = h1 - (upWeight / weight * friction + upLossFactor * qq);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Finds the flow of a link of the full network (cfs).
+
+bool Skeletonizer::findFlow(Network *nw, const string &linkName,
+                            double &flow) const {
+  int index = nw->indexOf(Element::LINK, linkName);
+  if (index >= 0) {
+    flow = nw->link(index)->flow;
+    return true;
+  }
+
+  auto ref = linkRefs.find(linkName);
+  if (ref == linkRefs.end())
+    return false;
+  if (ref->second.chain.empty()) {
+    flow = 0.0;
+    return true;
+  }
+
+  const Chain &chain = chains.at(ref->second.chain);
+  Link *link = nw->link(nw->indexOf(Element::LINK, ref->second.chain));
+  flow = chain.segments[ref->second.position].sign * link->flow;
+  return true;
+}
@@ -0,0 +1,96 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file skeletonizer.h
+//! \brief Describes the Skeletonizer class.
+
+#ifndef SKELETONIZER_H_
+#define SKELETONIZER_H_
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Network;
+class Link;
+class Node;
+class Pipe;
+
+//! \class Skeletonizer
+//! \brief Removes network elements that do not change the hydraulic solution.
+//!
+//! The reduction runs on a freshly loaded network, before the hydraulic
+//! engine is opened. Dead-end branches of zero-demand junctions are pruned
+//! (they carry no flow) and zero-demand junctions joining two pipes are
+//! removed by merging the pipes into one of equivalent resistance (both
+//! carry the same flow). Elements that are referenced by controls, flagged
+//! for reporting or listed by the caller are always kept. The heads and
+//! flows of the removed elements can be recovered from the reduced network.
+
+class Skeletonizer {
+public:
+  Skeletonizer();
+  ~Skeletonizer();
+
+  // Reduces the network, returns the number of nodes removed
+  int reduce(Network *nw, const std::set<std::string> &keepNodes,
+             const std::set<std::string> &keepLinks);
+  void clear();
+
+  // Results of elements of the full network (false if the name is unknown)
+  bool findHead(Network *nw, const std::string &nodeName, double &head) const;
+  bool findFlow(Network *nw, const std::string &linkName, double &flow) const;
+
+  int removedNodes() const { return (int)nodeRefs.size(); }
+  int removedLinks() const { return (int)linkRefs.size(); }
+
+private:
+  // A pipe of the original network absorbed into a surviving pipe
+  struct Segment {
+    std::string pipe;  // name of the original pipe
+    int sign;          // +1 if oriented like the surviving pipe
+    double weight;     // share of the friction head loss
+    double lossFactor; // minor loss factor (ft/cfs^2)
+  };
+
+  // Surviving pipe: segments[i] and segments[i+1] are joined by nodes[i]
+  struct Chain {
+    std::vector<Segment> segments;
+    std::vector<std::string> nodes;
+  };
+
+  // Where the result of a removed element comes from
+  struct Ref {
+    std::string chain;  // surviving pipe, or empty for a dead branch
+    std::string anchor; // node whose head is shared by a dead branch
+    int position;       // node or segment position within the chain
+  };
+
+  std::unordered_map<std::string, Chain> chains;
+  std::unordered_map<std::string, Ref> nodeRefs;
+  std::unordered_map<std::string, Ref> linkRefs;
+
+  // Working data, only used while reducing
+  std::vector<std::vector<Link *>> adjLinks; // links incident to each node
+  std::vector<char> nodeRemovable;           // node may be removed
+  std::vector<char> linkPrunable;            // pipe may be pruned
+  std::vector<char> linkMergeable;           // pipe may be merged
+  std::vector<char> nodeRemoved;
+  std::vector<char> linkRemoved;
+  bool sameSection; // merged pipes must share diameter and roughness
+
+  void markRemovable(Network *nw, const std::set<std::string> &keepNodes,
+                     const std::set<std::string> &keepLinks);
+  int pruneDeadEnds(Network *nw);
+  int mergeSeriesPipes(Network *nw);
+  bool canMerge(Link *link1, Link *link2, Node *node) const;
+  Chain &findChain(Pipe *pipe);
+};
+
+#endif // SKELETONIZER_H_
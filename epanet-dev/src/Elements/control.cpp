@@ -107,62 +107,16 @@ int Control::timeToActivate(Network *network, int t, int tod) {
 
 //-----------------------------------------------------------------------------
 
-bool Control::applyPressureControls(Network *network) {
-  bool makeChange = true;
-  bool changed = false;
-
-  for (Control *control : network->controls) {
-    if (control->type == PRESSURE_LEVEL) {
-      if ((control->levelType == LOW_LEVEL &&
-           control->node->head < control->head) ||
-          (control->levelType == HI_LEVEL &&
-           control->node->head > control->head)) {
-        if (control->activate(makeChange, network->msgLog))
-          changed = true;
-      }
-    }
-  }
-
-  return changed;
-}
-
-//-----------------------------------------------------------------------------
-
-void Control::apply(Network *network, int t, int tod) {
-  bool makeChange = true;
-  Tank *tank;
-
-  switch (type) {
-  case PRESSURE_LEVEL:
-    break;
-
-  case TANK_LEVEL:
-    tank = static_cast<Tank *>(node);
-    // ... use tolerance of one second's worth of inflow/outflow on action level
-    if ((levelType == LOW_LEVEL &&
-         tank->volume <= volume + abs(tank->outflow)) ||
-        (levelType == HI_LEVEL &&
-         tank->volume >= volume - abs(tank->outflow))) {
-      activate(makeChange, network->msgLog);
-    }
-    break;
-
-  case ELAPSED_TIME:
-    if (t == time)
-      activate(makeChange, network->msgLog);
-    break;
-
-  case TIME_OF_DAY:
-    if (tod == time)
-      activate(makeChange, network->msgLog);
-    break;
-  }
-}
+bool Control::activate(bool makeChange, ostream &msgLog) {
+  // ... the status message is only composed for a control that changes
+  //     its link
 
-//-----------------------------------------------------------------------------
+  bool result = (status != NO_STATUS)
+                    ? link->changeStatus(status, false, "", msgLog)
+                    : link->changeSetting(setting, false, "", msgLog);
+  if (!result || !makeChange)
+    return result;
 
-bool Control::activate(bool makeChange, ostream &msgLog) {
-  bool result = false;
   string reason = "";
   string linkStr = link->typeStr() + " " + link->name;
 
@@ -40,10 +40,6 @@ public:
   Control(int type_, std::string name_);
   ~Control();
 
-  // Applies all pressure controls to the pipe network,
-  // return true if status of any link changes
-  static bool applyPressureControls(Network *network);
-
   // Sets the properties of a control
   void setProperties(int controlType, Link *controlLink, int linkStatus,
                      double linkSetting, Node *controlNode, double nodeSetting,
@@ -58,11 +54,24 @@ public:
   // Returns the control's type (see ControlType enum)
   int getType() { return type; }
 
+  // Returns the link being controlled and the node triggering the control
+  Link *getLink() { return link; }
+  Node *getNode() { return node; }
+
+  // Returns the elapsed time or time of day (sec) triggering the control
+  int getTime() { return time; }
+
+  // Returns the type of node level trigger (see LevelType enum) and the
+  // head and tank volume at which it acts
+  int getLevelType() { return levelType; }
+  double getHead() { return head; }
+  double getVolume() { return volume; }
+
   // Finds the time until the control is next activated
   int timeToActivate(Network *network, int t, int tod);
 
-  // Checks if the control's conditions are met
-  void apply(Network *network, int t, int tod);
+  // Activates the control's action, returning true if it changes its link
+  bool activate(bool makeChange, std::ostream &msgLog);
 
   //! Serialize to JSON
   nlohmann::json to_json() const override { return {}; }
@@ -80,9 +89,6 @@ private:
   double volume;       //!< volume corresponding to head trigger
   LevelType levelType; //!< type of node head trigger
   int time;            //!< time (sec) that triggers control
-
-  // Activates the control's action
-  bool activate(bool makeChange, std::ostream &msgLog);
 };
 
 #endif
@@ -7,27 +7,15 @@
  */
 
 #include "demand.h"
-#include "pattern.h"
 
 //-----------------------------------------------------------------------------
 
 //  Demand Constructor
 
-Demand::Demand() : baseDemand(0.0), fullDemand(0.0), timePattern(nullptr) {}
+Demand::Demand() : baseDemand(0.0), timePattern(nullptr) {}
 
 //-----------------------------------------------------------------------------
 
 //  Demand Destructor
 
 Demand::~Demand() {}
-
-//-----------------------------------------------------------------------------
-
-//    Find pattern-adjusted full demand
-
-double Demand::getFullDemand(double multiplier, double patternFactor) {
-  if (timePattern)
-    patternFactor = timePattern->currentFactor();
-  fullDemand = multiplier * baseDemand * patternFactor;
-  return fullDemand;
-}
@@ -81,21 +81,18 @@ void Junction::initialize(Network *nw) {
 }
 
 //-----------------------------------------------------------------------------
-//    Find a junction's full demand
+//    Find a junction's actual demand flow and its derivative w.r.t. head
 //-----------------------------------------------------------------------------
-void Junction::findFullDemand(double multiplier, double patternFactor) {
-  fullDemand = 0.0;
-  for (Demand demand : demands) {
-    fullDemand += demand.getFullDemand(multiplier, patternFactor);
-  }
-  actualDemand = fullDemand;
+double Junction::findActualDemand(Network *nw, double h, double &dqdh) {
+  return nw->demandModel->findDemand(this, h - elev, dqdh);
 }
 
 //-----------------------------------------------------------------------------
-//    Find a junction's actual demand flow and its derivative w.r.t. head
+//    Find the pressure head needed to deliver a demand flow of q at head h
 //-----------------------------------------------------------------------------
-double Junction::findActualDemand(Network *nw, double h, double &dqdh) {
-  return nw->demandModel->findDemand(this, h - elev, dqdh);
+double Junction::findDemandPressure(Network *nw, double q, double h,
+                                    double &dpdq) {
+  return nw->demandModel->findPressure(this, q, h - elev, dpdq);
 }
 
 //-----------------------------------------------------------------------------
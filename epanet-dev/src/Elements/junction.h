@@ -31,8 +31,8 @@ public:
   int type() { return Node::JUNCTION; }
   void convertUnits(Network *nw);
   void initialize(Network *nw);
-  void findFullDemand(double multiplier, double patternFactor);
   double findActualDemand(Network *nw, double h, double &dqdh);
+  double findDemandPressure(Network *nw, double q, double h, double &dpdq);
   double findEmitterFlow(double h, double &dqdh);
   bool isPressureDeficient(Network *nw);
   bool hasEmitter() { return emitter != nullptr; }
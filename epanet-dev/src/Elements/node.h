@@ -47,7 +47,6 @@ public:
   virtual void initialize(Network *nw);
 
   // Overridden for Junction nodes
-  virtual void findFullDemand(double multiplier, double patternFactor) {}
   virtual double findActualDemand(Network *nw, double h, double &dqdh) {
     return 0;
   }
@@ -98,6 +98,7 @@ public:
   int nextTime(int t);
   void advance(int t);
   void setFactor(int idx, double f) { factors[idx] = f; }
+  int timeOffset() { return startTime; }
 
 private:
   int startTime; //!< offset from time 0 when the pattern begins (sec)
@@ -26,7 +26,8 @@ const double TINY_NUMBER = 1.0e-6; //!< numerical zero
 
 PumpCurve::PumpCurve()
     : curveType(NO_CURVE), curve(nullptr), horsepower(0.0), qInit(0.0),
-      qMax(0.0), hMax(0.0), h0(0.0), r(0.0), n(0.0), qUcf(1.0), hUcf(1.0) {}
+      qMax(0.0), hMax(0.0), h0(0.0), r(0.0), n(0.0), qUcf(1.0), hUcf(1.0),
+      speedUsed(0.0), h0Speed(0.0), rSpeed(0.0) {}
 
 //-----------------------------------------------------------------------------
 
@@ -77,6 +78,7 @@ int PumpCurve::setupCurve(Network *network) {
   else
     err = NetworkError::NO_PUMP_CURVE;
   qInit /= qUcf;
+  speedUsed = 0.0;
   return err;
 }
 
@@ -217,6 +219,19 @@ int PumpCurve::setupCustomCurve() {
   // ... initial flow is curve mid-point
 
   qInit = (curve->x(0) + curve->x(k)) / 2.0;
+
+  // ... tabulate the slope and intercept of each curve segment
+
+  segX.resize(k);
+  segSlope.resize(k);
+  segIntercept.resize(k);
+  for (int m = 1; m <= k; m++) {
+    double dx = curve->x(m) - curve->x(m - 1);
+    double s = (curve->y(m) - curve->y(m - 1)) / dx;
+    segX[m - 1] = curve->x(m);
+    segSlope[m - 1] = s;
+    segIntercept[m - 1] = curve->y(m) - s * curve->x(m);
+  }
   curveType = CUSTOM;
   return 0;
 }
@@ -231,19 +246,27 @@ void PumpCurve::customCurveHeadLoss(double speed, double flow, double &headLoss,
 
   double q = abs(flow) * qUcf;
 
-  // ... find slope and intercept of curve segment
+  // ... find the tabulated segment the flow at full speed falls in
+  //     (the last one if it lies beyond the curve)
 
-  curve->findSegment(q / speed, r, h0);
+  double qFull = q / speed;
+  int k = (int)segX.size() - 1;
+  for (int m = 0; m < k; m++) {
+    if (qFull <= segX[m]) {
+      k = m;
+      break;
+    }
+  }
 
   // ... adjust slope and intercept for pump speed
 
-  h0 = h0 * speed * speed;
-  r = r * speed;
+  double h1 = segIntercept[k] * speed * speed;
+  double r1 = segSlope[k] * speed;
 
   // ... evaluate head loss (negative of pump head) and its gradient
 
-  headLoss = -(h0 + r * q);
-  gradient = -r;
+  headLoss = -(h1 + r1 * q);
+  gradient = -r1;
 
   // ... convert results to internal units
 
@@ -273,21 +296,24 @@ void PumpCurve::powerFuncHeadLoss(double speed, double flow, double &headLoss,
 
   double q = abs(flow) * qUcf;
 
-  // ... adjust curve coeffs. for pump speed
+  // ... adjust curve coeffs. for pump speed (only when it changes)
 
-  double h01 = h0;
-  double r1 = r;
-  double w = 1.0;
-  if (speed != 1.0) {
-    w = speed * speed;
-    h01 *= w;
-    w = w / pow(speed, n);
+  if (speed != speedUsed) {
+    double w = 1.0;
+    h0Speed = h0;
+    if (speed != 1.0) {
+      w = speed * speed;
+      h0Speed *= w;
+      w = w / pow(speed, n);
+    }
+    rSpeed = w * r;
+    speedUsed = speed;
   }
 
   // ... evaluate head loss (negative of pump head) and its gradient
 
-  r1 = w * r * pow(q, n);
-  headLoss = -(h01 + r1);
+  double r1 = rSpeed * pow(q, n);
+  headLoss = -(h0Speed + r1);
   gradient = -(n * r1 / q);
 
   // ... convert results to internal units
@@ -14,10 +14,18 @@
 
 #include "Elements/curve.h"
 
+#include <vector>
+
 class Network;
 
 //! \class PumpCurve
 //! \brief Describes how head varies with flow for a Pump link.
+//!
+//! The slope and intercept of each segment of a custom curve are tabulated
+//! when the curve is set up, and the coefficients of a power function curve
+//! adjusted for pump speed are kept for the last speed used, so that each
+//! evaluation at a new flow neither recomputes segment coefficients nor
+//! raises the speed to a power.
 
 class PumpCurve {
 public:
@@ -71,6 +79,7 @@ public:
     n = j.at("n").get<double>();
     qUcf = j.at("qUcf").get<double>();
     hUcf = j.at("hUcf").get<double>();
+    speedUsed = 0.0;
   }
 
 private:
@@ -80,6 +89,14 @@ private:
   double qUcf; //!< flow units conversion factor
   double hUcf; //!< head units conversion factor
 
+  std::vector<double> segX;         //!< upper flow of each curve segment
+  std::vector<double> segSlope;     //!< head slope of each curve segment
+  std::vector<double> segIntercept; //!< head intercept of each segment
+
+  double speedUsed; //!< speed the adjusted coefficients apply to
+  double h0Speed;   //!< shutoff head adjusted for speedUsed
+  double rSpeed;    //!< flow coefficient adjusted for speedUsed
+
   void setupConstHpCurve();
   int setupPowerFuncCurve();
   int setupCustomCurve();
@@ -29,6 +29,8 @@ static const char *stringOptionKeywords[] = {"HYDRAULICS_FILE",
                                              "HYDRAULIC_SOLVER",
                                              "STEP_SIZING",
                                              "MATRIX_SOLVER",
+                                             "MATRIX_ORDERING",
+                                             "MATRIX_PRECISION",
                                              "",
                                              "QUALITY_MODEL",
                                              "QUALITY_NAME",
@@ -42,12 +44,14 @@ static const char *indexOptionKeywords[] = {
     "PRESSURE_UNITS",
     "MAXIMUM_TRIALS",
     "IF_UNBALANCED",
-    "", // reserved for hydraulics file mode
+    "HYDRAULICS_MODE",
     "DEMAND_PATTERN",
     "", // placeholder for ENERGY_PRICE_PATTERN
     "", // placeholder for QUAL_TYPE
     "", // placeholder for QUAL_UNITS
     "TRACE_NODE",
+    "MAXIMUM_SEGMENTS",
+    "MATRIX_PARALLEL_ROWS",
     0};
 
 // ... Keywords for reporting options portion of IndexOption enumeration
@@ -71,6 +75,7 @@ static const char *valueOptionKeywords[] = {"SPECIFIC_GRAVITY",
                                             "TIME_WEIGHT",
                                             "SPECIFIC_DIFFUSIVITY",
                                             "QUALITY_TOLERANCE",
+                                            "COURANT_NUMBER",
                                             0};
 
 // ... Keywords for TimeOption enumeration in options.h
@@ -105,6 +110,7 @@ static const char *epanetQualKeywords[] = {"NONE", "AGE", "TRACE", "CHEMICAL",
 //-----------------------------------------------------------------------------
 
 static const char *w_QUALITY = "QUALITY";
+static const char *w_HYDRAULICS = "HYDRAULICS";
 static const char *w_CHEMICAL = "CHEMICAL";
 // static const char* w_TRACE = "TRACE";
 static const char *w_DURATION = "DURATION";
@@ -156,6 +162,10 @@ void OptionParser::parseOption(Network *network, vector<string> &tokenList) {
     return;
   }
 
+  // ... EPANET2 "HYDRAULICS USE/SAVE filename" also sets the file mode
+  if (s1.compare(w_HYDRAULICS) == 0 && tokenList.size() > 2)
+    setOption(indexOptionKeywords[Options::HYD_FILE_MODE], s2, network);
+
   // ... get the equivalent EPANET3 keyword
   keyword = getEpanet3Keyword(s1, s2, value);
 
@@ -12,6 +12,12 @@
 #include <cmath>
 using namespace std;
 
+// Pressure band (ft) below minimum pressure over which a constrained demand
+// falls from full to zero, and the pressure gradient (ft per unit of full
+// demand) of the barriers holding a demand at zero or full demand.
+static const double PressureBand = 0.1;
+static const double BarrierGrad = 1.0e8;
+
 //-----------------------------------------------------------------------------
 // Parent constructor and destructor
 //-----------------------------------------------------------------------------
@@ -48,6 +54,12 @@ double DemandModel::findDemand(Junction *junc, double p, double &dqdh) {
   return junc->fullDemand;
 }
 
+double DemandModel::findPressure(Junction *junc, double q, double p,
+                                 double &dpdq) {
+  dpdq = 0.0;
+  return 0.0;
+}
+
 //-----------------------------------------------------------------------------
 ///  Fixed Demand Model
 //-----------------------------------------------------------------------------
@@ -60,24 +72,31 @@ FixedDemandModel::FixedDemandModel() {}
 
 ConstrainedDemandModel::ConstrainedDemandModel() {}
 
-bool ConstrainedDemandModel::isPressureDeficient(Junction *junc) {
-  // if ( junc->fixedGrade ||
-  //  ... return false if normal full demand is non-positive
-  if (junc->fullDemand <= 0.0)
-    return false;
-  double hMin = junc->elev + junc->pMin;
-  if (junc->head < hMin) {
-    junc->fixedGrade = true;
-    junc->head = hMin;
-    return true;
+double ConstrainedDemandModel::findPressure(Junction *junc, double q,
+                                           double p, double &dpdq) {
+  double qFull = junc->fullDemand;
+  double p0 = junc->pMin - PressureBand; // pressure head at no demand
+
+  // ... a demand at full (or no) demand stays there while the pressure
+  //     is above (below) the band, behind a steep barrier
+
+  if (q >= qFull && p >= junc->pMin) {
+    dpdq = BarrierGrad / qFull;
+    return junc->pMin + (q - qFull) * dpdq;
+  }
+  if (q <= 0.0 && p <= p0) {
+    dpdq = BarrierGrad / qFull;
+    return p0 + q * dpdq;
   }
-  return false;
+
+  // ... linear rise from no demand to full demand across the band
+
+  dpdq = PressureBand / qFull;
+  return p0 + q * dpdq;
 }
 
-double ConstrainedDemandModel::findDemand(Junction *junc, double p,
-                                          double &dqdh) {
-  dqdh = 0.0;
-  return junc->actualDemand;
+bool ConstrainedDemandModel::isPressureDeficient(Junction *junc) {
+  return junc->actualDemand < junc->fullDemand;
 }
 
 //-----------------------------------------------------------------------------
@@ -35,7 +35,16 @@ public:
   /// Finds demand flow and its derivative as a function of head.
   virtual double findDemand(Junction *junc, double h, double &dqdh);
 
-  /// Changes fixed grade status depending on pressure deficit.
+  /// Checks if demand flows are solved for together with heads, using
+  /// findPressure() instead of findDemand().
+  virtual bool isPressureDriven() { return false; }
+
+  /// Finds the pressure head needed to deliver a demand flow and its
+  /// derivative with respect to flow, given the junction's pressure head.
+  virtual double findPressure(Junction *junc, double q, double p,
+                              double &dpdq);
+
+  /// Checks if a junction's demand was reduced for lack of pressure.
   virtual bool isPressureDeficient(Junction *junc) { return false; }
 
   //! Serialize to JSON for DemandModel
@@ -63,13 +72,23 @@ public:
 //-----------------------------------------------------------------------------
 //! \class  ConstrainedDemandModel
 //! \brief A demand model where demands are reduced based on available pressure.
+//!
+//! A junction receives its full demand as long as its pressure is at least
+//! its minimum pressure. Below that, its demand falls linearly to zero over
+//! a narrow pressure band. The demand flows of junctions are solved for
+//! together with heads by the hydraulic solver, using the inverse of this
+//! curve, so that the reduced demands of pressure deficient junctions are
+//! found within its Newton iterations. Demands are kept between zero and
+//! full demand; one held at either limit by the junction's pressure sees
+//! a steep barrier instead of the curve.
 //-----------------------------------------------------------------------------
 
 class ConstrainedDemandModel : public DemandModel {
 public:
   ConstrainedDemandModel();
+  bool isPressureDriven() { return true; }
+  double findPressure(Junction *junc, double q, double p, double &dpdq);
   bool isPressureDeficient(Junction *junc);
-  double findDemand(Junction *junc, double p, double &dqdh);
 };
 
 //-----------------------------------------------------------------------------
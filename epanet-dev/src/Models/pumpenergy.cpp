@@ -22,7 +22,7 @@ static const double NO_FLOW = 2.23e-4; // cfs ( = 0.1 gpm)
 
 //-----------------------------------------------------------------------------
 
-PumpEnergy::PumpEnergy() { init(); }
+PumpEnergy::PumpEnergy() : speedUsed(1.0), speedFactor(1.0) { init(); }
 
 //-----------------------------------------------------------------------------
 
@@ -57,6 +57,7 @@ double PumpEnergy::updateEnergyUsage(Pump *pump, Network *network, int dt) {
 
   double sg = network->option(Options::SPEC_GRAVITY);
   double kw = head * pump->flow * sg / 8.814 / (e / 100.0) * KWperHP;
+  double costFactor = findCostFactor(pump, network);
 
   // ... convert time step to hours
 
@@ -71,9 +72,7 @@ double PumpEnergy::updateEnergyUsage(Pump *pump, Network *network, int dt) {
   kwHrsPerCFS =
       ((kwHrsPerCFS * hrsOnLine) + (kw / pump->flow * hrs)) / totalHrs;
 
-  totalCost =
-      ((totalCost * hrsOnLine) + (kw * findCostFactor(pump, network) * hrs)) /
-      totalHrs;
+  totalCost = ((totalCost * hrsOnLine) + (kw * costFactor * hrs)) / totalHrs;
 
   hrsOnLine = totalHrs;
   if (kw > maxKwatts)
@@ -81,7 +80,7 @@ double PumpEnergy::updateEnergyUsage(Pump *pump, Network *network, int dt) {
 
   // Calculate the total cost using the adjusted power (the patterns is in
   // cents)
-  adjustedTotalCost += kw * hrs * findCostFactor(pump, network) / 100.0;
+  adjustedTotalCost += kw * hrs * costFactor / 100.0;
 
   // Debugging
   // printf("       pump: %s\n", pump->name.c_str());
@@ -140,8 +139,13 @@ double PumpEnergy::findEfficiency(Pump *pump, Network *network) {
     // ... look up efficiency for the adjusted flow
     effic = pump->efficCurve->getYofX(q);
 
-    // ... apply the Sarbu and Borza pump speed adjustment
-    effic = 100.0 - ((100.0 - effic) * pow(1.0 / pump->speed, 0.1));
+    // ... apply the Sarbu and Borza pump speed adjustment (its factor
+    //     is only recomputed when the pump's speed changes)
+    if (pump->speed != speedUsed) {
+      speedFactor = pow(1.0 / pump->speed, 0.1);
+      speedUsed = pump->speed;
+    }
+    effic = 100.0 - ((100.0 - effic) * speedFactor);
     effic = min(effic, 100.0);
     effic = max(effic, 1.0);
   }
@@ -93,6 +93,9 @@ public:
   }
 
 private:
+  double speedUsed;   //!< pump speed that speedFactor applies to
+  double speedFactor; //!< efficiency speed adjustment factor
+
   double findCostFactor(Pump *pump, Network *network);
   double findEfficiency(Pump *pump, Network *network);
 };
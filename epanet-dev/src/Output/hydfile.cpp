@@ -0,0 +1,311 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "hydfile.h"
+#include "Core/constants.h"
+#include "Core/error.h"
+#include "Core/network.h"
+#include "Elements/link.h"
+#include "Elements/node.h"
+#include "Elements/pump.h"
+#include "Elements/tank.h"
+
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+//  File layout: a header of HeaderInts integers (magic number, version,
+//  node, link and tank counts, number of time steps, pump count) followed
+//  by one record per time step of two integers (time and step length, sec)
+//  and as doubles:
+//  - the flow, head loss, status and setting of each link,
+//  - the head, outflow, full demand and actual demand of each node (the
+//    head a tank had over the step rather than its updated one),
+//  - the volume and head of each tank, the PumpValues energy totals of
+//    each pump and the peak power at the end of the step.
+
+static const int HeaderInts = 8;
+static const size_t HeaderSize = HeaderInts * sizeof(int);
+static const int StepCountPos = 5;
+static const int PumpCountPos = 6;
+static const int LinkValues = 4;
+static const int NodeValues = 4;
+static const int TankValues = 2;
+static const int PumpValues = 7;
+
+//-----------------------------------------------------------------------------
+
+HydFile::HydFile()
+    : network(nullptr), nodeCount(0), linkCount(0), stepCount(0),
+      currentStep(0), stepSize(0), data(nullptr), dataSize(0) {}
+
+//-----------------------------------------------------------------------------
+
+HydFile::~HydFile() {
+  closeWriter();
+  closeReader();
+}
+
+//-----------------------------------------------------------------------------
+
+void HydFile::setCounts(Network *nw) {
+  network = nw;
+  nodeCount = nw->count(Element::NODE);
+  linkCount = nw->count(Element::LINK);
+  tanks.clear();
+  for (int i = 0; i < nodeCount; i++) {
+    if (nw->node(i)->type() == Node::TANK)
+      tanks.push_back(i);
+  }
+  pumps.clear();
+  for (int i = 0; i < linkCount; i++) {
+    if (nw->link(i)->type() == Link::PUMP)
+      pumps.push_back(i);
+  }
+  stepSize = 2 * sizeof(int) + valueCount() * sizeof(double);
+  stepCount = 0;
+  currentStep = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+size_t HydFile::valueCount() const {
+  return LinkValues * linkCount + NodeValues * nodeCount +
+         TankValues * tanks.size() + PumpValues * pumps.size() + 1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Create a new hydraulics file for a network.
+
+int HydFile::openWriter(const string &fileName, Network *nw) {
+  closeWriter();
+  fwriter.open(fileName.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!fwriter.is_open())
+    return FileError::CANNOT_OPEN_HYDRAULICS_FILE;
+  setCounts(nw);
+  buffer.resize(valueCount());
+
+  int header[HeaderInts] = {MAGICNUMBER,       VERSION, nodeCount, linkCount,
+                            (int)tanks.size(), 0,       (int)pumps.size(), 0};
+  fwriter.write((char *)header, HeaderSize);
+  if (fwriter.fail())
+    return FileError::CANNOT_OPEN_HYDRAULICS_FILE;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Save the network's hydraulic state for a time step of length tstep
+//  starting at time t, once its tank volumes and pump energy (and the peak
+//  power peakKwatts) have been updated over the step.
+
+int HydFile::writeStep(int t, int tstep, double peakKwatts) {
+  if (!fwriter.is_open())
+    return 0;
+  double *x = &buffer[0];
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = network->link(i);
+    *x++ = link->flow;
+    *x++ = link->hLoss;
+    *x++ = link->status;
+    *x++ = link->setting;
+  }
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = network->node(i);
+    if (node->type() == Node::TANK)
+      *x++ = static_cast<Tank *>(node)->pastHead;
+    else
+      *x++ = node->head;
+    *x++ = node->outflow;
+    *x++ = node->fullDemand;
+    *x++ = node->actualDemand;
+  }
+  for (int i : tanks) {
+    Tank *tank = static_cast<Tank *>(network->node(i));
+    *x++ = tank->volume;
+    *x++ = tank->head;
+  }
+  for (int i : pumps) {
+    const PumpEnergy &e = static_cast<Pump *>(network->link(i))->pumpEnergy;
+    *x++ = e.hrsOnLine;
+    *x++ = e.efficiency;
+    *x++ = e.kwHrsPerCFS;
+    *x++ = e.kwHrs;
+    *x++ = e.maxKwatts;
+    *x++ = e.totalCost;
+    *x++ = e.adjustedTotalCost;
+  }
+  *x++ = peakKwatts;
+
+  int times[2] = {t, tstep};
+  fwriter.write((char *)times, sizeof(times));
+  fwriter.write((char *)&buffer[0], buffer.size() * sizeof(double));
+  if (fwriter.fail())
+    return FileError::CANNOT_OPEN_HYDRAULICS_FILE;
+  stepCount++;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Record the number of time steps saved and close the file.
+
+int HydFile::closeWriter() {
+  if (!fwriter.is_open())
+    return 0;
+  fwriter.seekp(StepCountPos * sizeof(int));
+  fwriter.write((char *)&stepCount, sizeof(int));
+  bool failed = fwriter.fail();
+  fwriter.close();
+  return failed ? FileError::CANNOT_OPEN_HYDRAULICS_FILE : 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Open a hydraulics file saved for a network.
+
+int HydFile::openReader(const string &fileName, Network *nw) {
+  closeReader();
+  setCounts(nw);
+
+#ifndef _WIN32
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    return FileError::CANNOT_OPEN_HYDRAULICS_FILE;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) {
+      data = (const char *)p;
+      dataSize = st.st_size;
+    }
+  }
+  ::close(fd);
+#endif
+
+  // ... read the file into memory if it can't be mapped
+
+  if (data == nullptr) {
+    ifstream freader(fileName.c_str(), ios::in | ios::binary);
+    if (!freader.is_open())
+      return FileError::CANNOT_OPEN_HYDRAULICS_FILE;
+    dataCopy.assign(istreambuf_iterator<char>(freader),
+                    istreambuf_iterator<char>());
+    data = dataCopy.data();
+    dataSize = dataCopy.size();
+  }
+
+  // ... check that the file was saved for this network
+
+  int header[HeaderInts];
+  if (dataSize < HeaderSize) {
+    closeReader();
+    return FileError::INCOMPATIBLE_HYDRAULICS_FILE;
+  }
+  memcpy(header, data, HeaderSize);
+  stepCount = header[StepCountPos];
+  if (header[0] != MAGICNUMBER || header[1] != VERSION ||
+      header[2] != nodeCount || header[3] != linkCount ||
+      header[4] != (int)tanks.size() ||
+      header[PumpCountPos] != (int)pumps.size() ||
+      dataSize < HeaderSize + stepCount * stepSize) {
+    closeReader();
+    return FileError::INCOMPATIBLE_HYDRAULICS_FILE;
+  }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the time, length and saved values of the current time step.
+
+const double *HydFile::stepValues(int *t, int *tstep) {
+  if (data == nullptr || currentStep >= stepCount)
+    throw FileError(FileError::CANNOT_READ_HYDRAULICS_FILE);
+  const char *p = data + HeaderSize + currentStep * stepSize;
+  int times[2];
+  memcpy(times, p, sizeof(times));
+  *t = times[0];
+  *tstep = times[1];
+  return (const double *)(p + sizeof(times));
+}
+
+//-----------------------------------------------------------------------------
+
+//  Assign the link and node values saved for the current time step to the
+//  network, returning the step's starting time in t.
+
+void HydFile::readStep(int *t) {
+  int tstep;
+  const double *x = stepValues(t, &tstep);
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = network->link(i);
+    link->flow = *x++;
+    link->hLoss = *x++;
+    link->status = (int)*x++;
+    link->setting = *x++;
+  }
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = network->node(i);
+    node->head = *x++;
+    node->outflow = *x++;
+    node->fullDemand = *x++;
+    node->actualDemand = *x++;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Assign the tank volumes and heads and the pump energy totals at the end
+//  of the current time step to the network (keeping the tanks' values over
+//  the step as their past ones), returning the step's length in tstep and the
+//  peak power so far in peakKwatts, and move on to the next step.
+
+void HydFile::readAdvance(int *tstep, double *peakKwatts) {
+  int t;
+  const double *x = stepValues(&t, tstep) + LinkValues * linkCount +
+                    NodeValues * nodeCount;
+  for (int i : tanks) {
+    Tank *tank = static_cast<Tank *>(network->node(i));
+    tank->pastHead = tank->head;
+    tank->pastVolume = tank->volume;
+    tank->pastOutflow = tank->outflow;
+    tank->volume = *x++;
+    tank->head = *x++;
+  }
+  for (int i : pumps) {
+    PumpEnergy &e = static_cast<Pump *>(network->link(i))->pumpEnergy;
+    e.hrsOnLine = *x++;
+    e.efficiency = *x++;
+    e.kwHrsPerCFS = *x++;
+    e.kwHrs = *x++;
+    e.maxKwatts = *x++;
+    e.totalCost = *x++;
+    e.adjustedTotalCost = *x++;
+  }
+  *peakKwatts = *x++;
+  currentStep++;
+}
+
+//-----------------------------------------------------------------------------
+
+void HydFile::closeReader() {
+#ifndef _WIN32
+  if (data && dataCopy.empty())
+    munmap((void *)data, dataSize);
+#endif
+  data = nullptr;
+  dataSize = 0;
+  dataCopy.clear();
+}
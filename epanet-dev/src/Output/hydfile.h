@@ -0,0 +1,71 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file hydfile.h
+//! \brief Description of the HydFile class.
+
+#ifndef HYDFILE_H_
+#define HYDFILE_H_
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Network;
+
+//! \class HydFile
+//! \brief Saves the hydraulic trajectory of a run and replays it.
+//!
+//! Each hydraulic time step is saved with its time and length, the flow,
+//! head loss, status and setting of each link, the head, outflow and full
+//! and actual demands of each node, and what the step ends with: the volume
+//! of each tank, the energy totals of each pump and the peak power drawn.
+//! A replayed run thus reports the same hydraulics and energy use as the
+//! run that saved it, as well as driving the water quality engine.
+//! A file being used is mapped into memory read-only, so the projects of
+//! several water quality scenarios using the same file (each possibly on
+//! its own thread) share a single copy of it.
+
+class HydFile {
+public:
+  HydFile();
+  ~HydFile();
+
+  int openWriter(const std::string &fileName, Network *nw);
+  int writeStep(int t, int tstep, double peakKwatts);
+  int closeWriter();
+
+  int openReader(const std::string &fileName, Network *nw);
+  void readStep(int *t);
+  void readAdvance(int *tstep, double *peakKwatts);
+  void closeReader();
+
+private:
+  Network *network;      //!< associated network
+  int nodeCount;         //!< number of network nodes
+  int linkCount;         //!< number of network links
+  std::vector<int> tanks; //!< indexes of tank nodes
+  std::vector<int> pumps; //!< indexes of pump links
+  int stepCount;         //!< number of time steps saved
+  int currentStep;       //!< index of the step being read
+  std::size_t stepSize;  //!< bytes saved for each time step
+
+  std::ofstream fwriter;      //!< file output stream
+  std::vector<double> buffer; //!< values of the step being written
+
+  const char *data;            //!< contents of the file being read
+  std::size_t dataSize;        //!< size of the file being read (bytes)
+  std::vector<char> dataCopy;  //!< contents read if mapping fails
+
+  void setCounts(Network *nw);
+  std::size_t valueCount() const;
+  const double *stepValues(int *t, int *tstep);
+};
+
+#endif
@@ -10,8 +10,8 @@
 ////////////////////////////////////////////////////////////////////////
 
 // TO DO:
-// - implement the line search procedure and consider moving it to
-//   its own module so it can be used by other solvers
+// - consider moving the line search procedure to its own module so it
+//   can be used by other solvers
 
 #include "ggasolver.h"
 #include "Core/constants.h"
@@ -21,6 +21,8 @@
 #include "Elements/link.h"
 #include "Elements/tank.h"
 #include "matrixsolver.h"
+#include "sparspaklanes.h"
+#include "sparspaksolver.h"
 
 #include <algorithm>
 #include <cmath>
@@ -52,7 +54,12 @@ static const double ErrorThreshold = 1.0;
 static const double Huge = numeric_limits<double>::max();
 
 // step sizing enumeration
-enum StepSizing { FULL, RELAXATION, LINESEARCH };
+enum StepSizing { FULL, RELAXATION, LINESEARCH, ANDERSON };
+
+// line search and acceleration parameters
+static const double ArmijoSlope = 1.0e-4;   // required error decrease per unit step
+static const double MinStepSize = 0.0625;   // smallest step tried
+static const double MaxMixing = 2.0;        // largest Anderson mixing weight
 
 //-----------------------------------------------------------------------------
 
@@ -64,7 +71,9 @@ GGASolver::GGASolver(Network *nw, MatrixSolver *ms) : HydSolver(nw, ms) {
 
   dH.resize(nodeCount, 0); // nodal head changes
   dQ.resize(linkCount, 0); // link flow changes
+  dD.resize(nodeCount, 0); // pressure driven demand changes
   xQ.resize(nodeCount, 0); // nodal excess flow (inflow - outflow)
+  pressureDriven = false;
 
   hLossEvalCount = 0;
   trialsLimit = 0;
@@ -81,11 +90,22 @@ GGASolver::GGASolver(Network *nw, MatrixSolver *ms) : HydSolver(nw, ms) {
     stepSizing = RELAXATION;
   else if (network->option(Options::STEP_SIZING) == "LINESEARCH")
     stepSizing = LINESEARCH;
+  else if (network->option(Options::STEP_SIZING) == "ANDERSON")
+    stepSizing = ANDERSON;
   else
     stepSizing = FULL;
 
   errorNorm = 0.0;
   oldErrorNorm = 0.0;
+  trial = 0;
+  lamda = 1.0;
+  statusChanged = false;
+  hasLastStep = false;
+
+  aDiag = nullptr;
+  aOffDiag = nullptr;
+  aRhs = nullptr;
+  assemblyReady = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -95,6 +115,7 @@ GGASolver::GGASolver(Network *nw, MatrixSolver *ms) : HydSolver(nw, ms) {
 GGASolver::~GGASolver() {
   dH.clear();
   dQ.clear();
+  dD.clear();
   xQ.clear();
 }
 
@@ -103,16 +124,117 @@ GGASolver::~GGASolver() {
 //  Solve network for heads and flows
 
 int GGASolver::solve(double tstep_, int &trials) {
+  int statusCode = HydSolver::SUCCESSFUL;
+  if (beginSolve(tstep_, statusCode)) {
+    for (;;) {
+      int errorCode = beginTrial();
+      if (errorCode < 0)
+        errorCode = solveCore();
+      if (endTrial(errorCode, statusCode))
+        break;
+    }
+  }
+  trials = trial;
+  return statusCode;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Solve the networks of several GGA solvers whose matrices share the same
+//  structure in lockstep: each round performs one Newton trial of every
+//  lane that has not finished yet, and the linear systems of the trial are
+//  factorized and solved together. Each lane goes through exactly the same
+//  steps as it would in solve().
+
+void GGASolver::solveLanes(const vector<GGASolver *> &lanes,
+                           const vector<double> &tsteps, vector<int> &trials,
+                           vector<int> &statusCodes) {
+  size_t laneCount = lanes.size();
+  trials.assign(laneCount, 0);
+  statusCodes.assign(laneCount, HydSolver::SUCCESSFUL);
+
+  vector<MatrixSolver *> matrixSolvers;
+  for (GGASolver *lane : lanes)
+    matrixSolvers.push_back(lane->matrixSolver);
+  if (!SparspakLanes::canBatch(matrixSolvers)) {
+    for (size_t l = 0; l < laneCount; l++)
+      statusCodes[l] = lanes[l]->solve(tsteps[l], trials[l]);
+    return;
+  }
+
+  vector<size_t> active;
+  for (size_t l = 0; l < laneCount; l++) {
+    if (lanes[l]->beginSolve(tsteps[l], statusCodes[l]))
+      active.push_back(l);
+    else
+      trials[l] = lanes[l]->trial;
+  }
+
+  SparspakLanes batch;
+  vector<size_t> batched, stillActive;
+  vector<SparspakSolver *> solvers;
+  vector<double *> heads;
+  vector<int> errorCodes(laneCount, -1), errorRows;
+  while (!active.empty()) {
+    // ... assemble the trial's linear system of each lane
+
+    batched.clear();
+    for (size_t l : active) {
+      errorCodes[l] = lanes[l]->beginTrial();
+      if (errorCodes[l] < 0)
+        batched.push_back(l);
+    }
+
+    // ... solve them in groups of SparspakLanes::Lanes
+
+    for (size_t m = 0; m < batched.size(); m += SparspakLanes::Lanes) {
+      solvers.clear();
+      heads.clear();
+      size_t end = min(batched.size(), m + SparspakLanes::Lanes);
+      for (size_t q = m; q < end; q++) {
+        GGASolver *lane = lanes[batched[q]];
+        solvers.push_back((SparspakSolver *)lane->matrixSolver);
+        heads.push_back(&lane->coreHead[0]);
+      }
+      batch.solve(solvers, heads, errorRows);
+      for (size_t q = m; q < end; q++) {
+        GGASolver *lane = lanes[batched[q]];
+        int row = errorRows[q - m];
+        errorCodes[batched[q]] =
+            row >= 0 ? lane->network->graph.coreNodes[row] : -1;
+      }
+    }
+
+    // ... complete the trial of each lane
+
+    stillActive.clear();
+    for (size_t l : active) {
+      if (lanes[l]->endTrial(errorCodes[l], statusCodes[l]))
+        trials[l] = lanes[l]->trial;
+      else
+        stillActive.push_back(l);
+    }
+    active.swap(stillActive);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Initialize a solution over a time step of tstep_ seconds. Returns false
+//  (with the status in statusCode) if no trial is allowed.
+
+bool GGASolver::beginSolve(double tstep_, int &statusCode) {
   // ... initialize variables
 
-  double lamda = 1.0;
-  bool statusChanged = true;
-  bool converged = false;
+  lamda = 1.0;
+  statusChanged = true;
+  hasLastStep = false;
 
   errorNorm = Huge;
   hLossEvalCount = 0;
   tstep = tstep_;
-  trials = 1;
+  trial = 1;
+  pressureDriven = network->demandModel->isPressureDriven();
 
   // ... get time weighting option for tank updating
 
@@ -125,64 +247,126 @@ int GGASolver::solve(double tstep_, int &trials) {
 
   setConvergenceLimits();
 
-  // ... perform Newton iterations
+  statusCode = HydSolver::SUCCESSFUL;
+  if (trial > trialsLimit) {
+    statusCode = HydSolver::FAILED_NO_CONVERGENCE;
+    return false;
+  }
+  return true;
+}
 
-  while (trials <= trialsLimit) {
-    // ... save current error norm
+//-----------------------------------------------------------------------------
 
-    oldErrorNorm = errorNorm;
+//  Start a Newton trial by assembling the linearized system of the looped
+//  core. Returns -1 if successful or the index of an ill-conditioned node.
 
-    // ... determine which nodes have fixed heads (e.g., PRVs)
+int GGASolver::beginTrial() {
+  // ... save current error norm
 
-    setFixedGradeNodes();
+  oldErrorNorm = errorNorm;
 
-    // ... re-compute error norm if links change status
+  // ... determine which nodes have fixed heads (e.g., PRVs)
 
-    if (statusChanged) {
-      oldErrorNorm = findErrorNorm(0.0);
-      lamda = 1.0;
-    }
-    statusChanged = false;
+  setFixedGradeNodes();
 
-    // ... find changes in heads and flows
+  // ... re-compute error norm if links change status
 
-    int errorCode = findHeadChanges();
-    if (errorCode >= 0) {
-      Node *node = network->node(errorCode);
-      network->msgLog << endl << s_IllConditioned << node->name;
-      return HydSolver::FAILED_ILL_CONDITIONED;
-    }
-    findFlowChanges();
+  if (statusChanged) {
+    oldErrorNorm = findErrorNorm(0.0);
+    lamda = 1.0;
+    hasLastStep = false;
+  }
+  statusChanged = false;
 
-    // ... find step size to take for head/flow changes
-    //     (which evaluates new gradients for next trial)
+  // ... setup the coeff. matrix of the GGA linearized system
 
-    lamda = findStepSize(trials);
-    updateSolution(lamda);
+  setMatrixCoeffs();
 
-    // ... check for convergence
+  // ... only the looped core goes through the matrix solver, the heads
+  //     of the peeled tree branches follow by back-substitution
 
-    if (reportTrials)
-      reportTrial(trials, lamda);
-    converged = hasConverged();
+  int errorCode = eliminateTrees();
+  if (errorCode >= 0)
+    return errorCode;
 
-    // ... if close to convergence then check for any link status changes
+  // ... an iterative matrix solver starts from the heads reached by the
+  //     previous trial's head changes
 
-    if (converged) //|| errorNorm < ErrorThreshold )
-    {
-      statusChanged = linksChangedStatus();
-    }
+  const Graph &graph = network->graph;
+  int coreCount = graph.coreNodeCount();
+  for (int c = 0; c < coreCount; c++)
+    coreHead[c] = network->node(graph.coreNodes[c])->head;
+  return -1;
+}
 
-    // ... check if the current solution can be accepted
+//-----------------------------------------------------------------------------
 
-    if (converged && !statusChanged)
-      break;
-    trials++;
+//  Solve the assembled core system for new core heads. Returns -1 if
+//  successful or the index of an ill-conditioned node.
+
+int GGASolver::solveCore() {
+  // ... matrixSolver returns a negative integer if it runs successfully;
+  //     otherwise it returns the index of the row that caused it to fail
+
+  const Graph &graph = network->graph;
+  int errorCode = matrixSolver->solve(graph.coreNodeCount(), &coreHead[0]);
+  if (errorCode >= 0)
+    return graph.coreNodes[errorCode];
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Complete a Newton trial once the new core heads are known (errorCode is
+//  the index of an ill-conditioned node, or -1). Returns true when the
+//  solution is finished, with its status in statusCode.
+
+bool GGASolver::endTrial(int errorCode, int &statusCode) {
+  if (errorCode >= 0) {
+    Node *node = network->node(errorCode);
+    network->msgLog << endl << s_IllConditioned << node->name;
+    statusCode = HydSolver::FAILED_ILL_CONDITIONED;
+    return true;
   }
-  // if ( reportTrials ) network->msgLog << s_HlossEvals << hLossEvalCount;
-  if (trials > trialsLimit)
-    return HydSolver::FAILED_NO_CONVERGENCE;
-  return HydSolver::SUCCESSFUL;
+
+  // ... find changes in heads and flows
+
+  findHeadChanges();
+  findFlowChanges();
+  findDemandChanges();
+
+  // ... find step size to take for head/flow changes
+  //     (which evaluates new gradients for next trial)
+
+  lamda = findStepSize(trial);
+  updateSolution(lamda);
+
+  // ... check for convergence
+
+  if (reportTrials)
+    reportTrial(trial, lamda);
+  bool converged = hasConverged();
+
+  // ... if close to convergence then check for any link status changes
+
+  if (converged) //|| errorNorm < ErrorThreshold )
+  {
+    statusChanged = linksChangedStatus();
+  }
+
+  // ... check if the current solution can be accepted
+
+  if (converged && !statusChanged) {
+    statusCode = HydSolver::SUCCESSFUL;
+    return true;
+  }
+  trial++;
+  if (trial > trialsLimit) {
+    // if ( reportTrials ) network->msgLog << s_HlossEvals << hLossEvalCount;
+    statusCode = HydSolver::FAILED_NO_CONVERGENCE;
+    return true;
+  }
+  return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -221,6 +405,14 @@ void GGASolver::setConvergenceLimits() {
     flowErrLimit = Huge;
   if (flowChangeLimit == 0.0)
     flowChangeLimit = Huge;
+
+  // ... an iterative matrix solver must resolve heads and flows well below
+  //     the limits that judge convergence, since its errors accumulate
+  //     in the tank levels from one time step to the next
+
+  double headTol = (headErrLimit < Huge) ? headErrLimit : 0.005;
+  double flowTol = (flowErrLimit < Huge) ? 0.001 * flowErrLimit : 0.0;
+  matrixSolver->setTolerance(0.001 * headTol, flowTol);
 }
 
 //-----------------------------------------------------------------------------
@@ -264,35 +456,20 @@ void GGASolver::setFixedGradeNodes() {
 
 //-----------------------------------------------------------------------------
 
-//  Find changes in nodal heads by solving a linearized system of equations.
+//  Find the head change at each node from the new core heads.
 
-int GGASolver::findHeadChanges() {
-  // ... setup the coeff. matrix of the GGA linearized system
-
-  setMatrixCoeffs();
-
-  // ... temporarily use the head change array dH[] to store new heads
+void GGASolver::findHeadChanges() {
+  // ... the heads of the peeled tree branches follow from the core heads
+  //     (the head change array dH[] temporarily stores the new heads)
 
   double *h = &dH[0];
-
-  // ... solve the linearized GGA system for new nodal heads
-  //     (matrixSolver returns a negative integer if it runs successfully;
-  //      otherwise it returns the index of the row that caused it to fail.)
-
-  int errorCode = matrixSolver->solve(nodeCount, h);
-  if (errorCode >= 0)
-    return errorCode;
+  findTreeHeads(h);
 
   // ... save new heads as head changes
 
   for (int i = 0; i < nodeCount; i++) {
     dH[i] = h[i] - network->node(i)->head;
   }
-
-  // ... return a negative number indicating that
-  //     the matrix solver ran successfully
-
-  return -1;
 }
 
 //-----------------------------------------------------------------------------
@@ -336,9 +513,46 @@ void GGASolver::findFlowChanges() {
 
 //-----------------------------------------------------------------------------
 
+//  Check if a node's demand flow is solved for together with its head.
+
+bool GGASolver::hasDrivenDemand(Node *node) {
+  return pressureDriven && node->type() == Node::JUNCTION &&
+         !node->fixedGrade && node->fullDemand > 0.0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the changes in pressure driven demands resulting from a set of nodal
+//  head changes (each demand acts as a link from its junction to a point of
+//  fixed head whose head loss is the demand-pressure curve).
+
+void GGASolver::findDemandChanges() {
+  if (!pressureDriven)
+    return;
+  for (int i = 0; i < nodeCount; i++) {
+    dD[i] = 0.0;
+    Node *node = network->node(i);
+    if (!hasDrivenDemand(node))
+      continue;
+    double dpdq;
+    double p = static_cast<Junction *>(node)->findDemandPressure(
+        network, node->actualDemand, node->head, dpdq);
+    dD[i] = (node->head + dH[i] - node->elev - p) / dpdq;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Find how much of the head and flow changes to apply to a new solution.
 
 double GGASolver::findStepSize(int trials) {
+  // ... keep the head losses and outflows of the current solution for
+  //     the line search model
+
+  bool lineSearch = (stepSizing == LINESEARCH && trials > 1);
+  if (lineSearch)
+    saveCurrentBalance();
+
   // ... find the new error norm at full step size
 
   double lamda = 1.0;
@@ -358,20 +572,206 @@ double GGASolver::findStepSize(int trials) {
   // ... if called for, implement a line search procedure
   //     to find the best step size lamda to take
 
-  if (stepSizing == LINESEARCH && trials > 1) {
-    ////////////  TO BE IMPLEMENTED  ///////////////
+  if (lineSearch && errorNorm > (1.0 - ArmijoSlope) * oldErrorNorm) {
+    lamda = searchStepSize();
   }
+
+  // ... or mix the Newton step with the previous one
+
+  if (stepSizing == ANDERSON)
+    accelerate();
   return lamda;
 }
 
 //-----------------------------------------------------------------------------
 
+//  Save the head loss of each link and the outflow of each node at the
+//  current solution (found by the last error norm evaluation).
+
+void GGASolver::saveCurrentBalance() {
+  hLoss0.resize(linkCount);
+  hGrad0.resize(linkCount);
+  outflow0.resize(nodeCount);
+  for (int i = 0; i < linkCount; i++) {
+    hLoss0[i] = network->link(i)->hLoss;
+    hGrad0[i] = network->link(i)->hGrad;
+  }
+  for (int i = 0; i < nodeCount; i++)
+    outflow0[i] = network->node(i)->outflow;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Backtracking line search on the error norm. The full step was just
+//  evaluated; shorter steps are screened with a model of the error norm
+//  built from the head losses and outflows at both ends of the step, so
+//  that only the step finally chosen needs a full evaluation. The first
+//  step meeting the Armijo condition ends the search. The full step is
+//  kept if the chosen one turns out no better.
+
+double GGASolver::searchStepSize() {
+  double fullNorm = errorNorm;
+  double bestStep = 1.0;
+  double bestNorm = fullNorm;
+  for (double step = 0.5; step >= MinStepSize; step *= 0.5) {
+    double norm = findModelErrorNorm(step);
+    if (norm < bestNorm) {
+      bestStep = step;
+      bestNorm = norm;
+    }
+    if (norm <= (1.0 - ArmijoSlope * step) * oldErrorNorm)
+      break;
+  }
+  if (bestStep == 1.0)
+    return 1.0;
+
+  double norm = findErrorNorm(bestStep);
+  if (norm < fullNorm) {
+    errorNorm = norm;
+    return bestStep;
+  }
+  errorNorm = findErrorNorm(1.0);
+  return 1.0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Estimate the error norm for a step of size lamda: heads and link flows
+//  change linearly with lamda, each link's head loss follows the cubic
+//  through its values and gradients at both ends of the step and node
+//  outflows are interpolated linearly. No element is modified.
+
+double GGASolver::findModelErrorNorm(double lamda) {
+  double t = lamda;
+  double h00 = (2.0 * t - 3.0) * t * t + 1.0;
+  double h10 = ((t - 2.0) * t + 1.0) * t;
+  double h01 = (3.0 - 2.0 * t) * t * t;
+  double h11 = (t - 1.0) * t * t;
+
+  modelXQ.assign(nodeCount, 0.0);
+  double headNorm = 0.0;
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = network->link(i);
+    int n1 = link->fromNode->index;
+    int n2 = link->toNode->index;
+    double flow = link->flow + lamda * dQ[i];
+    modelXQ[n1] -= flow;
+    modelXQ[n2] += flow;
+
+    // ... links without a head gradient (e.g. active valves) have no error
+    if (link->hGrad == 0.0 || hGrad0[i] == 0.0)
+      continue;
+    double hLoss = h00 * hLoss0[i] + h10 * hGrad0[i] * dQ[i] +
+                   h01 * link->hLoss + h11 * link->hGrad * dQ[i];
+    double h1 = link->fromNode->head + lamda * dH[n1];
+    double h2 = link->toNode->head + lamda * dH[n2];
+    double err = h1 - h2 - hLoss;
+    headNorm += err * err;
+  }
+  if (linkCount > 0)
+    headNorm /= linkCount;
+
+  // ... only junctions of unknown head can be out of balance
+
+  double flowNorm = 0.0;
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = network->node(i);
+    if (node->type() != Node::JUNCTION || node->fixedGrade)
+      continue;
+    double outflow = outflow0[i] + lamda * (node->outflow - outflow0[i]);
+    double err = modelXQ[i] - outflow;
+    flowNorm += err * err;
+
+    // ... a pressure driven demand must also meet its demand-pressure curve
+    if (hasDrivenDemand(node)) {
+      double h = node->head + lamda * dH[i];
+      double q = node->actualDemand + lamda * dD[i];
+      q = min(max(q, 0.0), node->fullDemand);
+      double dpdq;
+      double p = static_cast<Junction *>(node)->findDemandPressure(
+          network, q, h, dpdq);
+      err = (h - node->elev - p) / dpdq;
+      flowNorm += err * err;
+    }
+  }
+  flowNorm /= nodeCount;
+  return sqrt(headNorm + flowNorm);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Anderson acceleration of depth one, treating a Newton trial as the
+//  fixed point map x -> x + d(x): the new step is d - g (s + d - dLast),
+//  where s is the last step taken and dLast the last Newton direction,
+//  with the weight g that minimizes |d - g (d - dLast)|. The mixed step
+//  replaces the Newton step (just evaluated) only if it lowers the error
+//  norm.
+
+void GGASolver::accelerate() {
+  if (lastDH.size() != dH.size()) {
+    lastDH.resize(nodeCount);
+    lastDQ.resize(linkCount);
+    lastStepH.resize(nodeCount);
+    lastStepQ.resize(linkCount);
+  }
+
+  bool mixed = false;
+  if (hasLastStep) {
+    double dd = 0.0, ddLast = 0.0;
+    for (int i = 0; i < nodeCount; i++) {
+      double diff = dH[i] - lastDH[i];
+      dd += dH[i] * diff;
+      ddLast += diff * diff;
+    }
+    for (int i = 0; i < linkCount; i++) {
+      double diff = dQ[i] - lastDQ[i];
+      dd += dQ[i] * diff;
+      ddLast += diff * diff;
+    }
+    double g = (ddLast > 0.0) ? dd / ddLast : 0.0;
+
+    if (g != 0.0 && abs(g) <= MaxMixing) {
+      // ... the Newton direction is kept in lastDH/lastDQ from here on
+      for (int i = 0; i < nodeCount; i++) {
+        double d = dH[i];
+        dH[i] = d - g * (lastStepH[i] + d - lastDH[i]);
+        lastDH[i] = d;
+      }
+      for (int i = 0; i < linkCount; i++) {
+        double d = dQ[i];
+        dQ[i] = d - g * (lastStepQ[i] + d - lastDQ[i]);
+        lastDQ[i] = d;
+      }
+      findDemandChanges();
+      double norm = findErrorNorm(1.0);
+      if (norm < errorNorm) {
+        errorNorm = norm;
+        mixed = true;
+      } else {
+        dH = lastDH;
+        dQ = lastDQ;
+        findDemandChanges();
+        errorNorm = findErrorNorm(1.0);
+      }
+    }
+  }
+  if (!mixed) {
+    lastDH = dH;
+    lastDQ = dQ;
+  }
+  lastStepH = dH;
+  lastStepQ = dQ;
+  hasLastStep = true;
+}
+
+//-----------------------------------------------------------------------------
+
 //  Compute the error norm associated with a given step size.
 
 double GGASolver::findErrorNorm(double lamda) {
   hLossEvalCount++;
   return hydBalance.evaluate(lamda, (double *)&dH[0], (double *)&dQ[0],
-                             (double *)&xQ[0], network);
+                             (double *)&dD[0], (double *)&xQ[0], network);
 }
 
 //-----------------------------------------------------------------------------
@@ -383,6 +783,15 @@ void GGASolver::updateSolution(double lamda) {
     network->node(i)->head += lamda * dH[i];
   for (int i = 0; i < linkCount; i++)
     network->link(i)->flow += lamda * dQ[i];
+  if (pressureDriven) {
+    for (int i = 0; i < nodeCount; i++) {
+      Node *node = network->node(i);
+      if (hasDrivenDemand(node)) {
+        double q = node->actualDemand + lamda * dD[i];
+        node->actualDemand = min(max(q, 0.0), node->fullDemand);
+      }
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -446,7 +855,13 @@ void GGASolver::reportTrial(int trials, double lamda) {
 //  Compute the coeffciient matrix of the linearized set of equations for heads.
 
 void GGASolver::setMatrixCoeffs() {
+  if (!assemblyReady)
+    initAssembly();
   memset(&xQ[0], 0, nodeCount * sizeof(double));
+  if (!treeDiag.empty()) {
+    memset(&treeDiag[0], 0, treeDiag.size() * sizeof(double));
+    memset(&treeRhs[0], 0, treeRhs.size() * sizeof(double));
+  }
   matrixSolver->reset();
   setLinkCoeffs();
   setNodeCoeffs();
@@ -455,9 +870,131 @@ void GGASolver::setMatrixCoeffs() {
 
 //-----------------------------------------------------------------------------
 
+//  Find where each node's row and each link's coefficients are stored, so
+//  that the matrix can be assembled without calling the matrix solver. The
+//  rows of the looped core are stored by the matrix solver, those of the
+//  peeled tree junctions in treeDiag and treeRhs until eliminateTrees().
+
+void GGASolver::initAssembly() {
+  const Graph &graph = network->graph;
+  int coreCount = graph.coreNodeCount();
+  int treeCount = (int)graph.treeNodes.size();
+  coreHead.resize(coreCount);
+  treeDiag.resize(treeCount);
+  treeRhs.resize(treeCount);
+  treeCoeff.resize(treeCount);
+
+  aDiag = matrixSolver->diagStorage();
+  aOffDiag = matrixSolver->offDiagStorage();
+  aRhs = matrixSolver->rhsStorage();
+  if (!(aDiag && aOffDiag && aRhs))
+    aDiag = aOffDiag = aRhs = nullptr;
+
+  // ... a core row is found at its storage position (or at its core index
+  //     for solvers without in-place storage), a peeled junction t at -1-t
+
+  nodePos.resize(nodeCount);
+  for (int c = 0; c < coreCount; c++)
+    nodePos[graph.coreNodes[c]] = aDiag ? matrixSolver->diagIndex(c) : c;
+  for (int t = 0; t < treeCount; t++)
+    nodePos[graph.treeNodes[t]] = -1 - t;
+
+  linkPos.resize(3 * linkCount);
+  for (int j = 0; j < linkCount; j++) {
+    Link *link = network->link(j);
+    int k = graph.coreLinkIndex[j];
+    linkPos[3 * j] = nodePos[link->fromNode->index];
+    linkPos[3 * j + 1] = nodePos[link->toNode->index];
+    linkPos[3 * j + 2] = (k >= 0 && aOffDiag) ? matrixSolver->offDiagIndex(k) : k;
+  }
+  assemblyReady = true;
+}
+
+//-----------------------------------------------------------------------------
+
+inline void GGASolver::addToDiag(int i, double a) {
+  int k = nodePos[i];
+  if (k < 0)
+    treeDiag[-1 - k] += a;
+  else if (aDiag)
+    aDiag[k] += a;
+  else
+    matrixSolver->addToDiag(k, a);
+}
+
+//-----------------------------------------------------------------------------
+
+inline void GGASolver::addToRhs(int i, double b) {
+  int k = nodePos[i];
+  if (k < 0)
+    treeRhs[-1 - k] += b;
+  else if (aRhs)
+    aRhs[k] += b;
+  else
+    matrixSolver->addToRhs(k, b);
+}
+
+//-----------------------------------------------------------------------------
+
+inline void GGASolver::setDiagAndRhs(int i, double a, double b) {
+  int k = nodePos[i];
+  if (k < 0) {
+    treeDiag[-1 - k] = a;
+    treeRhs[-1 - k] = b;
+  } else if (aDiag) {
+    aDiag[k] = a;
+    aRhs[k] = b;
+  } else {
+    matrixSolver->setDiag(k, a);
+    matrixSolver->setRhs(k, b);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Compute matrix coefficients for link head loss gradients.
 
 void GGASolver::setLinkCoeffs() {
+  // ... fast path: scatter directly into the solver's storage, leaving
+  //     the rows of peeled junctions (negative positions) to the helpers
+
+  if (aDiag) {
+    const int *pos = &linkPos[0];
+    for (int j = 0; j < linkCount; j++, pos += 3) {
+      Link *link = network->link(j);
+      if (link->hGrad == 0.0)
+        continue;
+
+      Node *node1 = link->fromNode;
+      Node *node2 = link->toNode;
+      xQ[node1->index] -= link->flow;
+      xQ[node2->index] += link->flow;
+
+      double a = 1.0 / link->hGrad;
+      double b = a * link->hLoss;
+
+      if (pos[0] < 0 || pos[1] < 0) {
+        addLinkCoeffs(link, a, b, pos[2]);
+        continue;
+      }
+      if (node1->fixedGrade) {
+        aRhs[pos[1]] += a * node1->head;
+      } else {
+        aDiag[pos[0]] += a;
+        aRhs[pos[0]] += b;
+      }
+      if (node2->fixedGrade) {
+        aRhs[pos[0]] += a * node2->head;
+      } else {
+        aDiag[pos[1]] += a;
+        aRhs[pos[1]] -= b;
+        if (!node1->fixedGrade)
+          aOffDiag[pos[2]] -= a;
+      }
+    }
+    return;
+  }
+
   for (int j = 0; j < linkCount; j++) {
     // ... skip links with zero head gradient
     //     (e.g. active pressure regulating valves)
@@ -466,54 +1003,64 @@ void GGASolver::setLinkCoeffs() {
     if (link->hGrad == 0.0)
       continue;
 
-    // ... identify end nodes of link
-
-    Node *node1 = link->fromNode;
-    Node *node2 = link->toNode;
-    int n1 = node1->index;
-    int n2 = node2->index;
-
     // ... update node flow balances
 
-    xQ[n1] -= link->flow;
-    xQ[n2] += link->flow;
+    xQ[link->fromNode->index] -= link->flow;
+    xQ[link->toNode->index] += link->flow;
 
     // ... a is contribution to coefficient matrix
     //     b is contribution to right hand side
 
     double a = 1.0 / link->hGrad;
     double b = a * link->hLoss;
+    addLinkCoeffs(link, a, b, linkPos[3 * j + 2]);
+  }
+}
 
-    // ... update off-diagonal coeff. of matrix if both start and
-    //     end nodes are not fixed grade
+//-----------------------------------------------------------------------------
 
-    if (!node1->fixedGrade && !node2->fixedGrade) {
-      matrixSolver->addToOffDiag(j, -a);
-    }
+//  Add the coefficients a (matrix) and b (r.h.s.) of a link whose
+//  off-diag. coeff. is found at position k (negative for a peeled link,
+//  which is eliminated by eliminateTrees()).
 
-    // ... if start node has fixed grade, then apply a to r.h.s.
-    //     of that node's row;
+void GGASolver::addLinkCoeffs(Link *link, double a, double b, int k) {
+  Node *node1 = link->fromNode;
+  Node *node2 = link->toNode;
+  int n1 = node1->index;
+  int n2 = node2->index;
 
-    if (node1->fixedGrade) {
-      matrixSolver->addToRhs(n2, a * node1->head);
-    }
+  // ... update off-diagonal coeff. of matrix if both start and
+  //     end nodes are not fixed grade
 
-    // ... otherwise add a to row's diagonal coeff. and
-    //     add b to its r.h.s.
+  if (!node1->fixedGrade && !node2->fixedGrade && k >= 0) {
+    if (aOffDiag)
+      aOffDiag[k] -= a;
+    else
+      matrixSolver->addToOffDiag(k, -a);
+  }
 
-    else {
-      matrixSolver->addToDiag(n1, a);
-      matrixSolver->addToRhs(n1, b);
-    }
+  // ... if start node has fixed grade, then apply a to r.h.s.
+  //     of that node's row;
 
-    // ... do the same for the end node, except subtract b from r.h.s
+  if (node1->fixedGrade) {
+    addToRhs(n2, a * node1->head);
+  }
 
-    if (node2->fixedGrade) {
-      matrixSolver->addToRhs(n1, a * node2->head);
-    } else {
-      matrixSolver->addToDiag(n2, a);
-      matrixSolver->addToRhs(n2, -b);
-    }
+  // ... otherwise add a to row's diagonal coeff. and
+  //     add b to its r.h.s.
+
+  else {
+    addToDiag(n1, a);
+    addToRhs(n1, b);
+  }
+
+  // ... do the same for the end node, except subtract b from r.h.s
+
+  if (node2->fixedGrade) {
+    addToRhs(n1, a * node2->head);
+  } else {
+    addToDiag(n2, a);
+    addToRhs(n2, -b);
   }
 }
 
@@ -533,10 +1080,10 @@ void GGASolver::setNodeCoeffs() {
       if (node->type() == Node::TANK && theta != 0.0) {
         Tank *tank = static_cast<Tank *>(node);
         double a = tank->area / (theta * tstep);
-        matrixSolver->addToDiag(i, a);
+        addToDiag(i, a);
 
         a = a * tank->pastHead + (1.0 - theta) * tank->pastOutflow / theta;
-        matrixSolver->addToRhs(i, a);
+        addToRhs(i, a);
       }
 
       // ... for junctions, add effect of external outflows
@@ -544,19 +1091,27 @@ void GGASolver::setNodeCoeffs() {
       else if (node->type() == Node::JUNCTION) {
         // ... update junction's net inflow
         xQ[i] -= node->outflow;
-        matrixSolver->addToDiag(i, node->qGrad);
-        matrixSolver->addToRhs(i, node->qGrad * node->head);
+        addToDiag(i, node->qGrad);
+        addToRhs(i, node->qGrad * node->head);
+
+        // ... a pressure driven demand is linearized about its flow
+        //     rather than about the junction's head
+        if (hasDrivenDemand(node)) {
+          double dpdq;
+          double p = static_cast<Junction *>(node)->findDemandPressure(
+              network, node->actualDemand, node->head, dpdq);
+          addToRhs(i, -(node->head - node->elev - p) / dpdq);
+        }
       }
 
       // ... add node's net inflow to r.h.s. row
-      matrixSolver->addToRhs(i, (double)xQ[i]);
+      addToRhs(i, xQ[i]);
     }
 
     // ... if node has fixed head, force solution to produce it
 
     else {
-      matrixSolver->setDiag(i, 1.0);
-      matrixSolver->setRhs(i, node->head);
+      setDiagAndRhs(i, 1.0, node->head);
     }
   }
 }
@@ -581,15 +1136,69 @@ void GGASolver::setValveCoeffs() {
     //     r.h.s. row of its upstream node
 
     if (link->isPRV()) {
-      matrixSolver->addToRhs(n1, (double)xQ[n2]);
+      addToRhs(n1, xQ[n2]);
     }
 
     // ... add net inflow of upstream node of a PSV to the
     //     r.h.s. row of its downstream node
 
     if (link->isPSV()) {
-      matrixSolver->addToRhs(n2, (double)xQ[n1]);
+      addToRhs(n2, xQ[n1]);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Eliminate the rows of the peeled tree junctions, leaves first, folding
+//  each one into its parent's row. Returns the index of a junction with a
+//  non-positive pivot, or -1 if all went well.
+
+int GGASolver::eliminateTrees() {
+  const Graph &graph = network->graph;
+  int treeCount = (int)graph.treeNodes.size();
+  for (int t = 0; t < treeCount; t++) {
+    int i = graph.treeNodes[t];
+    Link *link = network->link(graph.treeLinks[t]);
+    Node *parent = (link->fromNode->index == i) ? link->toNode : link->fromNode;
+
+    double pivot = treeDiag[t];
+    if (pivot <= 0.0)
+      return i;
+
+    // ... the link couples the junction with its parent only if neither
+    //     end has a fixed grade (otherwise it was moved to the r.h.s.)
+
+    double a = 0.0;
+    if (link->hGrad != 0.0 && !network->node(i)->fixedGrade &&
+        !parent->fixedGrade) {
+      a = 1.0 / link->hGrad;
+      int p = parent->index;
+      addToDiag(p, -a * a / pivot);
+      addToRhs(p, a * treeRhs[t] / pivot);
     }
+    treeCoeff[t] = a;
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Place the new core heads in h and back-substitute those of the peeled
+//  junctions, from the core outwards.
+
+void GGASolver::findTreeHeads(double h[]) {
+  const Graph &graph = network->graph;
+  int coreCount = graph.coreNodeCount();
+  for (int c = 0; c < coreCount; c++)
+    h[graph.coreNodes[c]] = coreHead[c];
+
+  for (int t = (int)graph.treeNodes.size() - 1; t >= 0; t--) {
+    int i = graph.treeNodes[t];
+    Link *link = network->link(graph.treeLinks[t]);
+    int p = (link->fromNode->index == i) ? link->toNode->index
+                                         : link->fromNode->index;
+    h[i] = (treeRhs[t] + treeCoeff[t] * h[p]) / treeDiag[t];
   }
 }
 
@@ -634,7 +1243,7 @@ bool GGASolver::linksChangedStatus() {
   // if ( result && reportTrials ) network->msgLog << endl;
 
   // --- look for status changes caused by pressure switch controls
-  if (Control::applyPressureControls(network))
+  if (network->controlProgram.applyPressureControls(network))
     result = true;
 
   return result;
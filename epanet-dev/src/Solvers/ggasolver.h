@@ -19,6 +19,8 @@
 #include <string>
 #include <vector>
 class HydSolver;
+class Link;
+class Node;
 
 //! \class GGASolver
 //! \brief A hydraulic solver based on Todini's Global Gradient Algorithm.
@@ -29,6 +31,12 @@ public:
   ~GGASolver();
   int solve(double tstep, int &trials);
 
+  // Solves several networks with the same matrix structure in lockstep
+  static void solveLanes(const std::vector<GGASolver *> &lanes,
+                         const std::vector<double> &tsteps,
+                         std::vector<int> &trials,
+                         std::vector<int> &statusCodes);
+
   //! Serialize to JSON for GGASolver
   nlohmann::json to_json() const override {
     nlohmann::json jsonObj = HydSolver::to_json();
@@ -135,19 +143,70 @@ private:
 
   std::vector<double> dH; // head change at each node (ft)
   std::vector<double> dQ; // flow change in each link (cfs)
+  std::vector<double> dD; // change in each pressure driven demand (cfs)
   std::vector<double> xQ; // node flow imbalances (cfs)
+  bool pressureDriven;    // demand flows are solved for with heads
+
+  // Newton iteration state kept between the phases of a trial
+  int trial;          // current trial
+  double lamda;       // step size of the last trial
+  bool statusChanged; // links changed status in the last trial
+
+  // Line search and acceleration
+  std::vector<double> hLoss0;    // link head losses at the current solution
+  std::vector<double> hGrad0;    // their gradients
+  std::vector<double> outflow0;  // node outflows at the current solution
+  std::vector<double> modelXQ;   // node flow imbalances of the model
+  std::vector<double> lastDH;    // last Newton head changes
+  std::vector<double> lastDQ;    // last Newton flow changes
+  std::vector<double> lastStepH; // last head changes taken
+  std::vector<double> lastStepQ; // last flow changes taken
+  bool hasLastStep;              // last changes belong to this solution
+
+  // Direct assembly into the matrix solver's storage; the rows of peeled
+  // tree junctions are kept apart until they are eliminated
+  double *aDiag;                 // diagonal coeffs. of A (nullptr if not supported)
+  double *aOffDiag;              // off-diagonal coeffs. of A
+  double *aRhs;                  // right hand side vector
+  std::vector<int> nodePos;      // storage position of each node's row (-1-t if peeled)
+  std::vector<int> linkPos;      // positions of each link's from row, to row and off-diag.
+  std::vector<double> treeDiag;  // diagonal coeff. (pivot) of each peeled junction's row
+  std::vector<double> treeRhs;   // r.h.s. of each peeled junction's row
+  std::vector<double> treeCoeff; // coupling of each peeled junction with its parent
+  std::vector<double> coreHead;  // new heads of the core nodes
+  bool assemblyReady;            // true once the positions were computed
 
   // Functions that assemble linear equation coefficients
+  void initAssembly();
+  void addToDiag(int i, double a);
+  void addToRhs(int i, double b);
+  void setDiagAndRhs(int i, double a, double b);
   void setFixedGradeNodes();
   void setMatrixCoeffs();
   void setLinkCoeffs();
+  void addLinkCoeffs(Link *link, double a, double b, int k);
   void setNodeCoeffs();
   void setValveCoeffs();
+  int eliminateTrees();
+  void findTreeHeads(double h[]);
+
+  // Phases of a solution: beginSolve() once, then for each trial
+  // beginTrial(), solveCore() and endTrial() until endTrial() returns true
+  bool beginSolve(double tstep, int &statusCode);
+  int beginTrial();
+  int solveCore();
+  bool endTrial(int errorCode, int &statusCode);
 
   // Functions that update the hydraulic solution
-  int findHeadChanges();
+  void findHeadChanges();
   void findFlowChanges();
+  void findDemandChanges();
+  bool hasDrivenDemand(Node *node);
   double findStepSize(int trials);
+  void saveCurrentBalance();
+  double searchStepSize();
+  double findModelErrorNorm(double lamda);
+  void accelerate();
   void updateSolution(double lamda);
 
   // Functions that check for convergence
@@ -11,6 +11,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 #include "ltdsolver.h"
+#include "Core/constants.h"
 #include "Core/error.h"
 #include "Core/network.h"
 #include "Core/qualbalance.h"
@@ -24,6 +25,9 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -34,10 +38,37 @@ LTDSolver::LTDSolver(Network *nw) : QualSolver(nw) {
   linkCount = network->count(Element::LINK);
   firstSegment.resize(linkCount, nullptr);
   lastSegment.resize(linkCount, nullptr);
+  segmentCount.resize(linkCount, 0);
   volIn.resize(nodeCount, 0);
   massIn.resize(nodeCount, 0);
+  releaseQual.resize(nodeCount, 0);
   cTol = network->option(Options::QUAL_TOLERANCE) / network->ucf(Units::CONCEN);
   tstep = 0.0;
+  maxSegments = network->option(Options::MAX_SEGMENTS);
+
+  // ... split the links into one block per thread on large networks
+
+  int parallelLinks = network->option(Options::PARALLEL_ROWS);
+  if (parallelLinks <= 0)
+    parallelLinks = DEFAULT_PARALLEL_ROWS;
+  blockCount = 1;
+#ifdef _OPENMP
+  if (linkCount >= parallelLinks)
+    blockCount = max(1, omp_get_max_threads());
+#endif
+  blockStart.resize(blockCount + 1);
+  linkBlock.resize(linkCount);
+  for (int b = 0; b <= blockCount; b++)
+    blockStart[b] = (int)((long long)linkCount * b / blockCount);
+  for (int b = 0; b < blockCount; b++) {
+    for (int k = blockStart[b]; k < blockStart[b + 1]; k++)
+      linkBlock[k] = b;
+    segPools.emplace_back(new SegPool());
+  }
+  if (blockCount > 1) {
+    volOut.resize(linkCount, 0);
+    massOut.resize(linkCount, 0);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -55,10 +86,12 @@ LTDSolver::~LTDSolver() {
 
 void LTDSolver::init() {
   // ... add one segment with downstream node quality to each pipe
-  segPool.init();
+  for (auto &segPool : segPools)
+    segPool->init();
   for (int k = 0; k < linkCount; k++) {
     firstSegment[k] = nullptr;
     lastSegment[k] = nullptr;
+    segmentCount[k] = 0;
     Link *link = network->link(k);
     double v = link->getVolume();
     addSegment(k, v, link->toNode->quality);
@@ -67,7 +100,7 @@ void LTDSolver::init() {
   for (Node *node : network->nodes) {
     if (node->type() == Node::TANK) {
       Tank *tank = static_cast<Tank *>(node);
-      tank->mixingModel.init(tank, &segPool, cTol);
+      tank->mixingModel.init(tank, segPools[0].get(), cTol);
     }
   }
 
@@ -107,16 +140,50 @@ int LTDSolver::solve(int *sortedLinks, int timeStep) {
   memset(&massIn[0], 0, nodeCount * sizeof(double));
 
   // ... release constituent mass flow from upstream node of each link
-  for (int i = 0; i < linkCount; i++)
-    release(sortedLinks[i]);
+  findReleaseQuality();
+  if (blockCount > 1) {
+    vector<double> inflowMass(blockCount, 0.0);
+#pragma omp parallel for num_threads(blockCount)
+    for (int b = 0; b < blockCount; b++) {
+      for (int k = blockStart[b]; k < blockStart[b + 1]; k++)
+        release(k, inflowMass[b]);
+    }
+    for (int b = 0; b < blockCount; b++)
+      network->qualBalance.updateInflow(inflowMass[b]);
+  } else {
+    for (int i = 0; i < linkCount; i++)
+      release(sortedLinks[i], network->qualBalance.inflowMass);
+  }
 
   // ... react contents of each pipe and tank
   if (network->qualModel->isReactive())
     react();
 
   // ... add mass & flow volume from each link to its downstream node
-  for (int i = 0; i < linkCount; i++)
-    transport(sortedLinks[i]);
+  if (blockCount > 1) {
+#pragma omp parallel for num_threads(blockCount)
+    for (int b = 0; b < blockCount; b++) {
+      for (int k = blockStart[b]; k < blockStart[b + 1]; k++) {
+        volOut[k] = 0.0;
+        massOut[k] = 0.0;
+        transport(k, volOut[k], massOut[k]);
+      }
+    }
+    for (int i = 0; i < linkCount; i++) {
+      int k = sortedLinks[i];
+      Link *link = network->link(k);
+      int j = (link->flow < 0.0) ? link->fromNode->index : link->toNode->index;
+      volIn[j] += volOut[k];
+      massIn[j] += massOut[k];
+    }
+  } else {
+    for (int i = 0; i < linkCount; i++) {
+      int k = sortedLinks[i];
+      Link *link = network->link(k);
+      int j = (link->flow < 0.0) ? link->fromNode->index : link->toNode->index;
+      transport(k, volIn[j], massIn[j]);
+    }
+  }
 
   // ... use accumulated inflow mass and volume at each
   //     node to update its constituent concentration
@@ -167,9 +234,25 @@ void LTDSolver::react() {
 
 //-----------------------------------------------------------------------------
 
-//  Release flow volume from the upstream node of a pipe
+//  Find the quality of the flow released from each node, including any
+//  source input (the same for every link leaving the node)
+
+void LTDSolver::findReleaseQuality() {
+  bool chemical = (network->qualModel->type == QualModel::CHEM);
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = network->node(i);
+    releaseQual[i] = node->quality;
+    if (chemical && node->qualSource && node->qualSource->outflow > 0.0)
+      releaseQual[i] = node->qualSource->getQuality(node);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Release flow volume from the upstream node of a pipe, adding any mass
+//  it receives from sources and reservoirs to inflowMass
 
-void LTDSolver::release(int k) {
+void LTDSolver::release(int k, double &inflowMass) {
   // ... find flow volume (v) released
   Link *link = network->link(k);
   double q = link->flow;
@@ -186,14 +269,14 @@ void LTDSolver::release(int k) {
 
   // ... modify node quality c to include any source input
   if (node->qualSource && network->qualModel->type == QualModel::CHEM) {
-    c = node->qualSource->getQuality(node);
-    network->qualBalance.updateInflow((c - c1) * v);
+    c = releaseQual[node->index];
+    inflowMass += (c - c1) * v;
   }
 
   // ... update mass balance with inflow from reservoirs
   if (node->type() == Node::RESERVOIR) {
     if (node->outflow < 0.0)
-      network->qualBalance.updateInflow(c1 * (-node->outflow) * tstep);
+      inflowMass += c1 * (-node->outflow) * tstep;
   }
 
   // ... reconcile mass balance for mass outflow from an empty tank
@@ -228,19 +311,15 @@ void LTDSolver::release(int k) {
 
 //-----------------------------------------------------------------------------
 
-//  Transport a pipe's flow volume into its downstream node
+//  Transport a pipe's flow volume out of its downstream end, adding the
+//  volume and mass transported to volOut and massOut
 
-void LTDSolver::transport(int k) {
+void LTDSolver::transport(int k, double &volOut, double &massOut) {
   // ... get flow rate (q) and flow volume (v)
   Link *link = network->link(k);
   double q = link->flow;
   double v = abs(q) * tstep;
 
-  // ... get index of downstream node
-  int j = link->toNode->index;
-  if (q < 0.0)
-    j = link->fromNode->index;
-
   // ... transport flow volume from leading segments into downstream
   //     node, removing segments as their volume is consumed
   while (v > 0.0) {
@@ -259,8 +338,8 @@ void LTDSolver::transport(int k) {
       vSeg = v;
 
     // ... update volume & mass entering downstream node
-    volIn[j] += vSeg;
-    massIn[j] += vSeg * seg->c;
+    volOut += vSeg;
+    massOut += vSeg * seg->c;
 
     // ... reduce remaining flow volume by amount transported
     v -= vSeg;
@@ -271,7 +350,8 @@ void LTDSolver::transport(int k) {
       firstSegment[k] = seg->next;
       if (firstSegment[k] == nullptr)
         lastSegment[k] = nullptr;
-      segPool.freeSegment(seg);
+      segPools[linkBlock[k]]->freeSegment(seg);
+      segmentCount[k]--;
     }
 
     // ... otherwise just reduce this segment's volume
@@ -307,7 +387,7 @@ void LTDSolver::updateNodeQuality() {
       else if (node->type() == Node::TANK) {
         Tank *tank = static_cast<Tank *>(node);
         node->quality = tank->mixingModel.findQuality(
-            tank->outflow * tstep, volIn[i], massIn[i], &segPool);
+            tank->outflow * tstep, volIn[i], massIn[i], segPools[0].get());
       }
     }
   }
@@ -388,7 +468,7 @@ void LTDSolver::addSegment(int k, double v, double c) {
     return;
 
   // ... get an unused volume segment from the segment pool
-  Segment *seg = segPool.getSegment(v, c);
+  Segment *seg = segPools[linkBlock[k]]->getSegment(v, c);
   if (seg == nullptr)
     throw SystemError(SystemError::OUT_OF_MEMORY);
 
@@ -401,4 +481,85 @@ void LTDSolver::addSegment(int k, double v, double c) {
   if (lastSeg)
     lastSeg->next = seg;
   lastSegment[k] = seg;
+
+  // ... keep the pipe within its segment limit
+  segmentCount[k]++;
+  if (maxSegments > 0 && segmentCount[k] > maxSegments)
+    limitSegments(k);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Merge segment seg of pipe k with the segment upstream of it, conserving
+//  their combined volume and mass
+
+void LTDSolver::mergeSegments(int k, Segment *seg) {
+  Segment *next = seg->next;
+  double v = seg->v + next->v;
+  if (v > 0.0)
+    seg->c = (seg->c * seg->v + next->c * next->v) / v;
+  seg->v = v;
+  seg->next = next->next;
+  if (lastSegment[k] == next)
+    lastSegment[k] = seg;
+  segPools[linkBlock[k]]->freeSegment(next);
+  segmentCount[k]--;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Merge the pair of adjacent segments in pipe k whose merger displaces the
+//  least mass
+
+void LTDSolver::limitSegments(int k) {
+  Segment *best = nullptr;
+  double bestMass = 0.0;
+  for (Segment *seg = firstSegment[k]; seg && seg->next; seg = seg->next) {
+    Segment *next = seg->next;
+    double mass = abs(seg->c - next->c) * seg->v * next->v / (seg->v + next->v);
+    if (best == nullptr || mass < bestMass) {
+      best = seg;
+      bestMass = mass;
+    }
+  }
+  if (best)
+    mergeSegments(k, best);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Merge adjacent segments of each pipe whose qualities are within the
+//  quality tolerance of each other (only when segments are limited)
+
+void LTDSolver::compact() {
+  if (maxSegments <= 0)
+    return;
+#pragma omp parallel for num_threads(blockCount) if (blockCount > 1)
+  for (int b = 0; b < blockCount; b++) {
+    for (int k = blockStart[b]; k < blockStart[b + 1]; k++) {
+      Segment *seg = firstSegment[k];
+      while (seg && seg->next) {
+        if (abs(seg->c - seg->next->c) < cTol)
+          mergeSegments(k, seg);
+        else
+          seg = seg->next;
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the number of segments in use and on the free lists of all segment
+//  pools and the memory (bytes) the pools hold
+
+void LTDSolver::getSegmentStats(int &liveSegs, int &freeSegs, double &bytes) {
+  liveSegs = 0;
+  freeSegs = 0;
+  bytes = 0.0;
+  for (auto &segPool : segPools) {
+    liveSegs += segPool->liveSegments();
+    freeSegs += segPool->freeSegments();
+    bytes += segPool->bytes();
+  }
 }
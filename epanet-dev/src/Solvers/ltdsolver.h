@@ -14,12 +14,27 @@
 
 #include "Solvers/qualsolver.h"
 #include "Utilities/segpool.h"
+#include <memory>
 #include <vector>
 
 class Network;
 
 //! \class LTDSolver
 //! \brief A water quality solver based on the Lagrangian Time Driven method.
+//!
+//! Within a time step, releasing flow into each link and transporting it
+//! out again only read the nodes' qualities, which are not updated until
+//! all links have been processed. On large networks the links are split
+//! into fixed blocks that are processed on separate threads, each with its
+//! own pool of segments; the flow volume and mass leaving each link are
+//! then added to the downstream nodes in link order.
+//!
+//! If a maximum number of segments per link is set, a link that exceeds it
+//! has the pair of adjacent segments whose merger displaces the least mass
+//! combined, and once per hydraulic time step adjacent segments whose
+//! concentrations differ by less than the quality tolerance are merged.
+//! Merging conserves both volume and mass, so the number of live segments
+//! (and the memory their pools hold) stays bounded over long runs.
 
 class LTDSolver : public QualSolver {
 public:
@@ -29,27 +44,42 @@ public:
   void init();
   void reverseFlow(int k);
   int solve(int *sortedLinks, int timeStep);
+  void compact();
+  void getSegmentStats(int &liveSegs, int &freeSegs, double &bytes);
 
 private:
   int nodeCount; // number of nodes
   int linkCount; // number of links
   double cTol;   // quality tolerance (mass/ft3)
   double tstep;  // time step (sec)
+  int maxSegments; // max. segments in a link (0 for no limit)
 
   std::vector<double> volIn;           // volume inflow to each node
   std::vector<double> massIn;          // mass inflow to each node
+  std::vector<double> releaseQual;     // quality released from each node
   std::vector<Segment *> firstSegment; // ptr. to first segment in each link
   std::vector<Segment *> lastSegment;  // ptr. to last segment in each link
-  SegPool segPool;                     // pool of pipe segment objects
+  std::vector<int> segmentCount;       // number of segments in each link
 
+  int blockCount;                      // number of blocks of links
+  std::vector<int> blockStart;         // first link of each block
+  std::vector<int> linkBlock;          // block of each link
+  std::vector<std::unique_ptr<SegPool>> segPools; // segments of each block
+                                                  // (tanks use the first)
+  std::vector<double> volOut;          // volume leaving each link
+  std::vector<double> massOut;         // mass leaving each link
+
+  void findReleaseQuality();
   void react();
-  void release(int k);
-  void transport(int k);
+  void release(int k, double &inflowMass);
+  void transport(int k, double &volOut, double &massOut);
   void updateNodeQuality();
   void updateLinkQuality();
   double findStoredMass();
   void updateMassBalance();
   void addSegment(int k, double v, double c);
+  void mergeSegments(int k, Segment *seg);
+  void limitSegments(int k);
 };
 
 #endif
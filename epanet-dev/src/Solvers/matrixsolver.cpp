@@ -9,6 +9,7 @@
 #include "matrixsolver.h"
 
 // Include headers for the different matrix solvers here
+#include "pcgsolver.h"
 #include "sparspaksolver.h"
 // #include "cholmodsolver.h"
 
@@ -22,5 +23,7 @@ MatrixSolver *MatrixSolver::factory(const string name, ostream &logger) {
   // if (name == "CHOLMOD") return new CholmodSolver();
   if (name == "SPARSPAK")
     return new SparspakSolver(logger);
+  if (name == "PCG")
+    return new PcgSolver(logger);
   return nullptr;
 }
@@ -12,6 +12,7 @@
 #ifndef MATRIXSOLVER_H_
 #define MATRIXSOLVER_H_
 
+#include <memory>
 #include <nlohmann/json.hpp> // Include nlohmann/json header
 #include <ostream>
 #include <string>
@@ -19,6 +20,8 @@
 
 #include "Utilities/utilities.h"
 
+struct SymbolicFactor;
+
 class MatrixSolverData {
 public:
   std::vector<double> lnz;
@@ -57,6 +60,35 @@ public:
   virtual void addToRhs(int row, double b) = 0;
   virtual int solve(int nRows, double x[]) = 0;
 
+  // Accuracy required of an iterative solution: error of each x[i] within
+  // xTol and residual of each row within bTol (ignored by direct solvers,
+  // which also ignore the value of x passed to solve())
+  virtual void setTolerance(double xTol, double bTol) {}
+
+  // Row ordering used by direct solvers; must be set before init()
+  virtual void setOrdering(const std::string &ordering) {}
+
+  // Precision of the factor of A used by direct solvers; must be set
+  // before init()
+  virtual void setPrecision(const std::string &precision) {}
+
+  // Number of rows from which a solver runs on threads (0 = its default)
+  virtual void setParallelRows(int rows) {}
+
+  // Symbolic factorization shared by direct solvers of matrices with the
+  // same sparsity pattern; must be set before init()
+  virtual void shareSymbolicFactor(std::shared_ptr<SymbolicFactor> cache) {}
+
+  // Direct access to the storage of A and b for assembly without virtual
+  // calls: row i is stored at position diagIndex(i) of the diagonal and
+  // r.h.s. arrays, off-diagonal coeff. j at offDiagIndex(j). Solvers that
+  // do not keep A in place return nullptr arrays.
+  virtual double *diagStorage() { return nullptr; }
+  virtual double *offDiagStorage() { return nullptr; }
+  virtual double *rhsStorage() { return nullptr; }
+  virtual int diagIndex(int i) { return i; }
+  virtual int offDiagIndex(int j) { return j; }
+
   virtual void debug(std::ostream &out) {}
 
   virtual nlohmann::json to_json() const = 0;
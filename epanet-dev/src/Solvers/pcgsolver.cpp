@@ -0,0 +1,276 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "pcgsolver.h"
+#include "Core/constants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+
+// Solver limits
+//-----------------------------------------------------------------------------
+static const int MinIterations = 100;         // iterations always allowed
+static const double PivotRatio = 1.0e-8;      // incomplete factor breakdown
+static const double DefaultXTol = 1.0e-6;     // default allowable error in x
+
+//-----------------------------------------------------------------------------
+
+PcgSolver::PcgSolver(ostream &logger)
+    : nrows(0), msgLog(logger), xTol(DefaultXTol),
+      bTol(numeric_limits<double>::max()),
+      parallelRows(DEFAULT_PARALLEL_ROWS) {}
+
+PcgSolver::~PcgSolver() {}
+
+//-----------------------------------------------------------------------------
+
+//  Build the CSR structure of A from the row/column of each off-diag. coeff.
+//  (coeffs. of parallel links share the same non-zero).
+
+int PcgSolver::init(int nrows_, int nnz, int *xrow, int *xcol) {
+  nrows = nrows_;
+
+  // ... collect both triangles of each off-diag. coeff.
+
+  vector<vector<pair<int, int>>> rows(nrows);
+  offIndex.assign(nnz, -1);
+  int nOffDiag = 0;
+  for (int j = 0; j < nnz; j++) {
+    int i = xrow[j];
+    int k = xcol[j];
+    if (i == k)
+      continue;
+    for (auto &entry : rows[i]) {
+      if (entry.first == k)
+        offIndex[j] = entry.second;
+    }
+    if (offIndex[j] < 0) {
+      offIndex[j] = nOffDiag++;
+      rows[i].push_back({k, offIndex[j]});
+      rows[k].push_back({i, offIndex[j]});
+    }
+  }
+
+  // ... coeffs. with equal row and column have no place in A; give them
+  //     a dummy slot that is never read
+
+  for (int j = 0; j < nnz; j++) {
+    if (offIndex[j] < 0)
+      offIndex[j] = nOffDiag;
+  }
+
+  rowBeg.assign(nrows + 1, 0);
+  lowEnd.assign(nrows, 0);
+  col.clear();
+  pos.clear();
+  for (int i = 0; i < nrows; i++) {
+    sort(rows[i].begin(), rows[i].end());
+    rowBeg[i] = col.size();
+    lowEnd[i] = rowBeg[i];
+    for (auto &entry : rows[i]) {
+      col.push_back(entry.first);
+      pos.push_back(entry.second);
+      if (entry.first < i)
+        lowEnd[i]++;
+    }
+  }
+  rowBeg[nrows] = col.size();
+
+  diag.assign(nrows, 0.0);
+  rhs.assign(nrows, 0.0);
+  offDiag.assign(nOffDiag + 1, 0.0);
+  aval.assign(col.size(), 0.0);
+  lval.assign(col.size(), 0.0);
+  ldiag.assign(nrows, 0.0);
+  r.assign(nrows, 0.0);
+  z.assign(nrows, 0.0);
+  p.assign(nrows, 0.0);
+  q.assign(nrows, 0.0);
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void PcgSolver::reset() {
+  fill(diag.begin(), diag.end(), 0.0);
+  fill(offDiag.begin(), offDiag.end(), 0.0);
+  fill(rhs.begin(), rhs.end(), 0.0);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Set the accuracy required of a solution: the estimated error of each
+//  x[i] must be within xTol and the residual of each row within bTol.
+
+void PcgSolver::setTolerance(double xTol_, double bTol_) {
+  xTol = (xTol_ > 0.0) ? xTol_ : DefaultXTol;
+  bTol = (bTol_ > 0.0) ? bTol_ : numeric_limits<double>::max();
+}
+
+//-----------------------------------------------------------------------------
+
+void PcgSolver::setParallelRows(int rows) {
+  parallelRows = (rows > 0) ? rows : DEFAULT_PARALLEL_ROWS;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Solve Ax = b starting from the value of x on entry. Returns -1 if
+//  successful or the index of a row with a non-positive diagonal.
+
+//  If the tolerances are not met within the iteration limit the last
+//  iterate is returned; the hydraulic solver's own convergence tests
+//  decide whether it is good enough.
+
+int PcgSolver::solve(int n, double x[]) {
+  int nnz = (int)col.size();
+#pragma omp parallel for if (nnz >= parallelRows)
+  for (int m = 0; m < nnz; m++)
+    aval[m] = offDiag[pos[m]];
+
+  int errorRow = factorize();
+  if (errorRow >= 0)
+    return errorRow;
+
+  // ... initial residual r = b - Ax and search direction
+
+  multiply(x, &q[0]);
+  for (int i = 0; i < nrows; i++)
+    r[i] = rhs[i] - q[i];
+  precondition(&r[0], &z[0]);
+  p = z;
+  double rz = 0.0;
+#pragma omp parallel for reduction(+ : rz) if (nrows >= parallelRows)
+  for (int i = 0; i < nrows; i++)
+    rz += r[i] * z[i];
+
+  int maxIterations = max(MinIterations, nrows);
+  for (int iter = 0; iter < maxIterations; iter++) {
+    // ... check for convergence
+
+    double zMax = 0.0, rMax = 0.0;
+#pragma omp parallel for reduction(max : zMax, rMax) if (nrows >= parallelRows)
+    for (int i = 0; i < nrows; i++) {
+      zMax = max(zMax, abs(z[i]));
+      rMax = max(rMax, abs(r[i]));
+    }
+    if (zMax <= xTol && rMax <= bTol)
+      break;
+
+    // ... step along p
+
+    multiply(&p[0], &q[0]);
+    double pq = 0.0;
+#pragma omp parallel for reduction(+ : pq) if (nrows >= parallelRows)
+    for (int i = 0; i < nrows; i++)
+      pq += p[i] * q[i];
+    if (pq <= 0.0 || rz <= 0.0)
+      break;
+    double alpha = rz / pq;
+#pragma omp parallel for if (nrows >= parallelRows)
+    for (int i = 0; i < nrows; i++) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+    }
+
+    // ... new search direction, conjugate to the previous ones
+
+    precondition(&r[0], &z[0]);
+    double rzNew = 0.0;
+#pragma omp parallel for reduction(+ : rzNew) if (nrows >= parallelRows)
+    for (int i = 0; i < nrows; i++)
+      rzNew += r[i] * z[i];
+    double beta = rzNew / rz;
+    rz = rzNew;
+#pragma omp parallel for if (nrows >= parallelRows)
+    for (int i = 0; i < nrows; i++)
+      p[i] = z[i] + beta * p[i];
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Compute the incomplete Cholesky factor L of A, restricted to the
+//  non-zero pattern of A. Returns -1 if successful or the index of a row
+//  with a non-positive diagonal.
+
+int PcgSolver::factorize() {
+  for (int i = 0; i < nrows; i++) {
+    if (diag[i] <= 0.0)
+      return i;
+    double d = diag[i];
+    for (int m = rowBeg[i]; m < lowEnd[i]; m++) {
+      // ... subtract the product of rows i and k left of column k
+
+      int k = col[m];
+      double s = aval[m];
+      int a = rowBeg[i];
+      int b = rowBeg[k];
+      while (a < m && b < lowEnd[k]) {
+        if (col[a] < col[b])
+          a++;
+        else if (col[a] > col[b])
+          b++;
+        else
+          s -= lval[a++] * lval[b++];
+      }
+      lval[m] = s / ldiag[k];
+      d -= lval[m] * lval[m];
+    }
+
+    // ... fall back to the diagonal where the incomplete factor breaks down
+
+    if (d <= PivotRatio * diag[i]) {
+      for (int m = rowBeg[i]; m < lowEnd[i]; m++)
+        lval[m] = 0.0;
+      d = diag[i];
+    }
+    ldiag[i] = sqrt(d);
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Solve L L' zz = rr.
+
+void PcgSolver::precondition(const double *rr, double *zz) {
+  // ... forward substitution with L
+
+  for (int i = 0; i < nrows; i++) {
+    double s = rr[i];
+    for (int m = rowBeg[i]; m < lowEnd[i]; m++)
+      s -= lval[m] * zz[col[m]];
+    zz[i] = s / ldiag[i];
+  }
+
+  // ... backward substitution with L', column by column
+
+  for (int i = nrows - 1; i >= 0; i--) {
+    zz[i] /= ldiag[i];
+    for (int m = rowBeg[i]; m < lowEnd[i]; m++)
+      zz[col[m]] -= lval[m] * zz[i];
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Compute yy = A xx.
+
+void PcgSolver::multiply(const double *xx, double *yy) const {
+#pragma omp parallel for if (nrows >= parallelRows)
+  for (int i = 0; i < nrows; i++) {
+    double s = diag[i] * xx[i];
+    for (int m = rowBeg[i]; m < rowBeg[i + 1]; m++)
+      s += aval[m] * xx[col[m]];
+    yy[i] = s;
+  }
+}
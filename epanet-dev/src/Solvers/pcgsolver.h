@@ -0,0 +1,118 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file pcgsolver.h
+//! \brief Description of the PcgSolver class.
+
+#ifndef PCGSOLVER_H_
+#define PCGSOLVER_H_
+
+#include "matrixsolver.h"
+
+#include <vector>
+
+//! \class PcgSolver
+//! \brief Solves Ax = b by preconditioned conjugate gradients.
+//!
+//! This class is derived from the MatrixSolver class and solves the
+//! sparse, symmetric, positive definite set of equations Ax = b
+//! iteratively, with an incomplete Cholesky factor of A (no fill-in) as
+//! preconditioner. Its storage grows only with the number of non-zeros
+//! of A, which makes it suited to very large networks whose direct
+//! factorization fills in badly. A is kept in compressed row (CSR) form
+//! and the matrix-vector products and vector updates are multi-threaded
+//! on large systems. The value of x on entry is used as initial guess.
+
+class PcgSolver : public MatrixSolver {
+public:
+  // Constructor/Destructor
+
+  PcgSolver(std::ostream &logger);
+  ~PcgSolver();
+
+  // Methods
+
+  int init(int nrows, int nnz, int *xrow, int *xcol);
+  void reset();
+
+  double getDiag(int i) { return diag[i]; }
+  double getOffDiag(int i) { return offDiag[offIndex[i]]; }
+  double getRhs(int i) { return rhs[i]; }
+
+  void setDiag(int i, double a) { diag[i] = a; }
+  void setRhs(int i, double b) { rhs[i] = b; }
+  void addToDiag(int i, double a) { diag[i] += a; }
+  void addToOffDiag(int j, double a) { offDiag[offIndex[j]] += a; }
+  void addToRhs(int i, double b) { rhs[i] += b; }
+  int solve(int n, double x[]);
+
+  void setTolerance(double xTol, double bTol);
+  void setParallelRows(int rows);
+
+  double *diagStorage() { return diag.data(); }
+  double *offDiagStorage() { return offDiag.data(); }
+  double *rhsStorage() { return rhs.data(); }
+  int diagIndex(int i) { return i; }
+  int offDiagIndex(int j) { return offIndex[j]; }
+
+  //! Serialize to JSON for PcgSolver
+  nlohmann::json to_json() const override {
+    return {{"lnz", offDiag}, {"diag", diag}, {"rhs", rhs}};
+  }
+
+  //! Deserialize from JSON for PcgSolver
+  void from_json(const nlohmann::json &j) override {
+    offDiag = j.at("lnz").get<std::vector<double>>();
+    diag = j.at("diag").get<std::vector<double>>();
+    rhs = j.at("rhs").get<std::vector<double>>();
+  }
+
+  void copy_to(MatrixSolverData &data) const override {
+    data.lnz = offDiag;
+    data.diag = diag;
+    data.rhs = rhs;
+  }
+
+  void copy_from(const MatrixSolverData &data) override {
+    std::copy(data.lnz.begin(), data.lnz.end(), offDiag.begin());
+    std::copy(data.diag.begin(), data.diag.end(), diag.begin());
+    std::copy(data.rhs.begin(), data.rhs.end(), rhs.begin());
+  }
+
+private:
+  int nrows;                // number of rows in system Ax = b
+  std::vector<double> diag; // diagonal coeffs. of A
+  std::vector<double> offDiag; // distinct off-diag. coeffs. of A
+  std::vector<double> rhs;     // right hand side vector
+  std::vector<int> offIndex;   // distinct off-diag. coeff. of each input one
+  std::ostream &msgLog;
+
+  // A in CSR form (both triangles, columns sorted within each row)
+  std::vector<int> rowBeg;  // start of each row in col/pos
+  std::vector<int> col;     // column of each non-zero
+  std::vector<int> pos;     // distinct off-diag. coeff. of each non-zero
+  std::vector<double> aval; // value of each non-zero
+  std::vector<int> lowEnd;  // end of the strictly lower part of each row
+
+  // Incomplete Cholesky factor L (same pattern as the lower part of A)
+  std::vector<double> lval;  // off-diag. coeffs. of L, stored like aval
+  std::vector<double> ldiag; // diagonal of L
+
+  // Work vectors
+  std::vector<double> r, z, p, q;
+
+  double xTol; // allowable error in x (estimated by the preconditioned residual)
+  double bTol; // allowable residual of Ax = b
+  int parallelRows; // rows (or non-zeros for SpMV) needed to use threads
+
+  int factorize();
+  void precondition(const double *rr, double *zz);
+  void multiply(const double *xx, double *yy) const;
+};
+
+#endif
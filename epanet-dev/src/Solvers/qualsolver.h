@@ -34,6 +34,12 @@ public:
   virtual void init() {}
   virtual void reverseFlow(int linkIndex) {}
   virtual int solve(int *sortedLinks, int timeStep) = 0;
+  virtual void compact() {}
+  virtual void getSegmentStats(int &liveSegs, int &freeSegs, double &bytes) {
+    liveSegs = 0;
+    freeSegs = 0;
+    bytes = 0.0;
+  }
 
 protected:
   Network *network;
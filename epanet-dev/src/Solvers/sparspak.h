@@ -31,6 +31,6 @@ void sp_numfct(int neqns, int *xlnz, double *lnz, int *xnzsub, int *nzsub,
 
 void sp_solve(int neqns, int *xlnz, double *lnz, int *xnzsub, int *nzsub,
               double *diag, double *rhs);
-// Solves the factorized system LDL'x = b.
+// Solves the factorized system LL'x = b.
 
 #endif
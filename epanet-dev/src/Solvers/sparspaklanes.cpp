@@ -0,0 +1,241 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "sparspaklanes.h"
+#include "sparspaksolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+static const int W = SparspakLanes::Lanes;
+
+//-----------------------------------------------------------------------------
+
+SparspakLanes::SparspakLanes() : nrows(0), nnzl(0) {}
+
+SparspakLanes::~SparspakLanes() {}
+
+//-----------------------------------------------------------------------------
+
+bool SparspakLanes::canBatch(const vector<MatrixSolver *> &solvers) {
+  const SparspakSolver *s0 = nullptr;
+  for (MatrixSolver *ms : solvers) {
+    const SparspakSolver *s = dynamic_cast<const SparspakSolver *>(ms);
+    if (s == nullptr || s->lnz == nullptr)
+      return false;
+    if (s0 == nullptr) {
+      s0 = s;
+      continue;
+    }
+    if (s->nrows != s0->nrows || s->nnzl != s0->nnzl)
+      return false;
+    int n = s->nrows;
+    int nsub = 0;
+    for (int j = 0; j < n; j++)
+      nsub = max(nsub, s->xnzsub[j] - 1 + s->xlnz[j + 1] - s->xlnz[j]);
+    if (memcmp(s->invp, s0->invp, n * sizeof(int)) ||
+        memcmp(s->xlnz, s0->xlnz, (n + 1) * sizeof(int)) ||
+        memcmp(s->xnzsub, s0->xnzsub, (n + 1) * sizeof(int)) ||
+        memcmp(s->nzsub, s0->nzsub, nsub * sizeof(int)))
+      return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakLanes::resize(int nrows_, int nnzl_) {
+  nrows = nrows_;
+  nnzl = nnzl_;
+  lnz.resize((size_t)nnzl * W);
+  diag.resize((size_t)nrows * W);
+  rhs.resize((size_t)nrows * W);
+  temp.assign((size_t)nrows * W, 0.0);
+  link.resize(nrows);
+  first.resize(nrows);
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakLanes::solve(const vector<SparspakSolver *> &solvers,
+                          const vector<double *> &x, vector<int> &errorRows) {
+  int lanes = (int)solvers.size();
+  errorRows.assign(lanes, -1);
+  if (lanes == 0)
+    return;
+  const SparspakSolver *s = solvers[0];
+  resize(s->nrows, s->nnzl);
+
+  // ... gather the systems (already in permuted order); unused lanes
+  //     get an identity matrix
+
+  for (int l = 0; l < W; l++) {
+    const SparspakSolver *sl = solvers[l < lanes ? l : 0];
+    for (int k = 0; k < nnzl; k++)
+      lnz[k * W + l] = l < lanes ? sl->lnz[k] : 0.0;
+    for (int j = 0; j < nrows; j++) {
+      diag[j * W + l] = l < lanes ? sl->diag[j] : 1.0;
+      rhs[j * W + l] = l < lanes ? sl->rhs[j] : 0.0;
+    }
+  }
+
+  int errorCols[W];
+  factorize(s, errorCols);
+  solve(s);
+
+  // ... scatter the solutions; the factors kept by the solvers no longer
+  //     belong to their current matrices
+
+  for (int l = 0; l < lanes; l++) {
+    solvers[l]->factorValid = false;
+    if (errorCols[l] >= 0) {
+      errorRows[l] = s->invp[errorCols[l]] - 1;
+      continue;
+    }
+    for (int i = 0; i < nrows; i++)
+      x[l][i] = rhs[(s->invp[i] - 1) * W + l];
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Numerical factorization of all lanes in the column order of sp_numfct.
+//  errorCols[l] is -1 or the first column of lane l with a non-positive
+//  pivot; that lane then continues with a unit pivot and is discarded.
+
+void SparspakLanes::factorize(const SparspakSolver *s, int errorCols[]) {
+  const int *xlnz = s->xlnz;
+  const int *xnzsub = s->xnzsub;
+  const int *nzsub = s->nzsub;
+
+  for (int l = 0; l < W; l++)
+    errorCols[l] = -1;
+  for (int j = 0; j < nrows; j++)
+    link[j] = -1;
+
+  double diagj[W];
+  double ljk[W];
+  for (int j = 0; j < nrows; j++) {
+    // ... modify column j by each column k linked to it
+    for (int l = 0; l < W; l++)
+      diagj[l] = 0.0;
+    int newk = link[j];
+    while (newk >= 0) {
+      int k = newk;
+      newk = link[k];
+      int kfirst = first[k];
+#pragma omp simd
+      for (int l = 0; l < W; l++) {
+        ljk[l] = lnz[kfirst * W + l];
+        diagj[l] += ljk[l] * ljk[l];
+      }
+      int istrt = kfirst + 1;
+      int istop = xlnz[k + 1] - 1;
+      if (istrt >= istop)
+        continue;
+
+      // ... link column k to the next column it modifies
+      first[k] = istrt;
+      int i = xnzsub[k] - 1 + (kfirst - (xlnz[k] - 1)) + 1;
+      int isub = nzsub[i] - 1;
+      link[k] = link[isub];
+      link[isub] = k;
+
+      for (int ii = istrt; ii < istop; ii++, i++) {
+        double *t = &temp[(nzsub[i] - 1) * W];
+        const double *a = &lnz[ii * W];
+#pragma omp simd
+        for (int l = 0; l < W; l++)
+          t[l] += a[l] * ljk[l];
+      }
+    }
+
+    // ... pivot of column j, masking out lanes that break down
+    for (int l = 0; l < W; l++) {
+      diagj[l] = diag[j * W + l] - diagj[l];
+      if (diagj[l] <= 0.0) {
+        if (errorCols[l] < 0)
+          errorCols[l] = j;
+        diagj[l] = 1.0;
+      }
+    }
+#pragma omp simd
+    for (int l = 0; l < W; l++) {
+      diagj[l] = sqrt(diagj[l]);
+      diag[j * W + l] = diagj[l];
+    }
+
+    // ... apply the accumulated modifications to column j
+    int istrt = xlnz[j] - 1;
+    int istop = xlnz[j + 1] - 1;
+    if (istop > istrt) {
+      first[j] = istrt;
+      int i = xnzsub[j] - 1;
+      int isub = nzsub[i] - 1;
+      link[j] = link[isub];
+      link[isub] = j;
+      for (int ii = istrt; ii < istop; ii++, i++) {
+        double *t = &temp[(nzsub[i] - 1) * W];
+        double *a = &lnz[ii * W];
+#pragma omp simd
+        for (int l = 0; l < W; l++) {
+          a[l] = (a[l] - t[l]) / diagj[l];
+          t[l] = 0.0;
+        }
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Forward and backward substitution of all lanes, as in sp_solve.
+
+void SparspakLanes::solve(const SparspakSolver *s) {
+  const int *xlnz = s->xlnz;
+  const int *xnzsub = s->xnzsub;
+  const int *nzsub = s->nzsub;
+
+  double rhsj[W];
+  for (int j = 0; j < nrows; j++) {
+    double *b = &rhs[j * W];
+#pragma omp simd
+    for (int l = 0; l < W; l++) {
+      rhsj[l] = b[l] / diag[j * W + l];
+      b[l] = rhsj[l];
+    }
+    int i = xnzsub[j] - 1;
+    for (int ii = xlnz[j] - 1; ii < xlnz[j + 1] - 1; ii++, i++) {
+      double *bi = &rhs[(nzsub[i] - 1) * W];
+      const double *a = &lnz[ii * W];
+#pragma omp simd
+      for (int l = 0; l < W; l++)
+        bi[l] -= a[l] * rhsj[l];
+    }
+  }
+
+  double sum[W];
+  for (int j = nrows - 1; j >= 0; j--) {
+    double *b = &rhs[j * W];
+    for (int l = 0; l < W; l++)
+      sum[l] = b[l];
+    int i = xnzsub[j] - 1;
+    for (int ii = xlnz[j] - 1; ii < xlnz[j + 1] - 1; ii++, i++) {
+      const double *bi = &rhs[(nzsub[i] - 1) * W];
+      const double *a = &lnz[ii * W];
+#pragma omp simd
+      for (int l = 0; l < W; l++)
+        sum[l] -= a[l] * bi[l];
+    }
+#pragma omp simd
+    for (int l = 0; l < W; l++)
+      b[l] = sum[l] / diag[j * W + l];
+  }
+}
@@ -0,0 +1,66 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file sparspaklanes.h
+//! \brief Description of the SparspakLanes class.
+
+#ifndef SPARSPAKLANES_H_
+#define SPARSPAKLANES_H_
+
+#include <vector>
+
+class MatrixSolver;
+class SparspakSolver;
+
+//! \class SparspakLanes
+//! \brief Factorizes and solves several systems with the same structure
+//!        at once.
+//!
+//! Networks that differ only in the status or setting of their links (e.g.
+//! candidate pump schedules) produce GGA matrices with the same sparsity
+//! pattern and hence the same symbolic factor. This class takes the
+//! assembled systems of up to Lanes SparspakSolvers that share a symbolic
+//! factor and runs the SPARSPAK numerical factorization and triangular
+//! solves on all of them in lockstep. Values are stored lane-interleaved
+//! (entry k of lane l at k * Lanes + l) so that every operation of the
+//! factorization is a vector operation across lanes. Each lane performs
+//! the same arithmetic as sp_numfct and sp_solve would on its own system;
+//! a lane whose factorization breaks down is masked out of the results.
+
+class SparspakLanes {
+public:
+  static const int Lanes = 8;
+
+  SparspakLanes();
+  ~SparspakLanes();
+
+  // True if the solvers are SparspakSolvers with the same symbolic factor
+  static bool canBatch(const std::vector<MatrixSolver *> &solvers);
+
+  // Solves the systems of the solvers (at most Lanes of them), leaving the
+  // solution of each in x[l]; errorRows[l] is -1 if lane l succeeded or
+  // the row that made its matrix ill-conditioned
+  void solve(const std::vector<SparspakSolver *> &solvers,
+             const std::vector<double *> &x, std::vector<int> &errorRows);
+
+private:
+  int nrows;                // number of rows of each system
+  int nnzl;                 // number of off-diag. coeffs. of each factor
+  std::vector<double> lnz;  // off-diag. coeffs. of A, then of L
+  std::vector<double> diag; // diagonal of A, then of L
+  std::vector<double> rhs;  // right hand sides, then solutions
+  std::vector<double> temp; // accumulated column modifications
+  std::vector<int> link;    // columns that modify each column next
+  std::vector<int> first;   // next entry of each column used to modify
+
+  void resize(int nrows, int nnzl);
+  void factorize(const SparspakSolver *s, int errorCols[]);
+  void solve(const SparspakSolver *s);
+};
+
+#endif
@@ -7,14 +7,39 @@
  */
 
 #include "sparspaksolver.h"
+#include "Core/constants.h"
+#include "Utilities/graph.h"
 #include "sparspak.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <ctime>
 #include <iostream>
 #include <limits>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 using namespace std;
 
+// Limits on modifying the factor of the previous matrix instead of
+// factorizing the new one from scratch
+//-----------------------------------------------------------------------------
+static const int MinUpdateRank = 2;         // rank always worth an update
+static const int UpdateRankDivisor = 20;    // otherwise at most nrows / 20
+static const int MaxUpdatesPerFactor = 64;  // refactor after this many updates
+static const double MinDiagRatio = 1.0e-8;  // downdate breakdown threshold
+
+// Limits on processing subtrees of the elimination tree concurrently
+//-----------------------------------------------------------------------------
+static const int TasksPerThread = 4; // subtrees per thread
+
+// Limits on refining a single precision solution
+//-----------------------------------------------------------------------------
+static const int MaxRefinements = 10;         // corrections per solve
+static const double MinRefinementRate = 0.5;  // required residual shrinkage
+
 // Local module-level functions
 //-----------------------------------------------------------------------------
 int compress(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
@@ -26,6 +51,7 @@ void sortAdjncy(int n, int nnz, int *xadj, int *adjncy, int *xadj2,
 void transpose(int n, int *xadj1, int *adjncy1, int *xadj2, int *adjncy2,
                int *nz);
 int reorder(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl);
+int reorderND(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl);
 int factorize(int n, int &nnzl, int *xadj, int *adjncy, int *perm, int *invp,
               int *xlnz, int *xnzsub, int *nzsub);
 void aij2lnz(int nnz, int *xrow, int *xcol, int *invp, int *xlnz, int *xnzsub,
@@ -36,7 +62,10 @@ void aij2lnz(int nnz, int *xrow, int *xcol, int *invp, int *xlnz, int *xnzsub,
 SparspakSolver::SparspakSolver(ostream &logger)
     : nrows(0), nnz(0), nnzl(0), perm(0), invp(0), xlnz(0), xnzsub(0), nzsub(0),
       xaij(0), link(0), first(0), lnz(0), diag(0), rhs(0), temp(0),
-      msgLog(logger) {}
+      msgLog(logger), lfac(0), dfac(0), aprev(0), dprev(0), work(0),
+      marker(0), nOffDiag(0), offPos(0), offRow(0), offCol(0), updateCount(0),
+      factorValid(false), nestedDissection(false),
+      parallelRows(DEFAULT_PARALLEL_ROWS), mixedPrecision(false) {}
 
 //-----------------------------------------------------------------------------
 
@@ -53,6 +82,39 @@ SparspakSolver::~SparspakSolver() {
   delete[] diag;
   delete[] rhs;
   delete[] temp;
+  delete[] lfac;
+  delete[] dfac;
+  delete[] aprev;
+  delete[] dprev;
+  delete[] work;
+  delete[] marker;
+  delete[] offPos;
+  delete[] offRow;
+  delete[] offCol;
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSolver::setOrdering(const string &ordering) {
+  nestedDissection = (ordering == "ND");
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSolver::setPrecision(const string &precision) {
+  mixedPrecision = (precision == "MIXED");
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSolver::setParallelRows(int rows) {
+  parallelRows = (rows > 0) ? rows : DEFAULT_PARALLEL_ROWS;
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSolver::shareSymbolicFactor(shared_ptr<SymbolicFactor> cache) {
+  symbolic = cache;
 }
 
 //-----------------------------------------------------------------------------
@@ -74,9 +136,16 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
   if (!perm || !invp)
     return 0;
 
+  // ... re-use a shared symbolic factorization of the same matrix structure
+  if (loadSymbolicFactor(xrow, xcol)) {
+    findSubtrees();
+    return allocNumericArrays() && allocUpdateArrays(xrow, xcol);
+  }
+
   // ... compress, re-order, and factorize coeff. matrix A
   int *xadj;
   int *adjncy;
+  int nnzsub = 0;
   int flag = 0;
   for (;;) {
     // ... allocate space for adjacency lists
@@ -91,7 +160,10 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
 
     // ... re-order the rows of A to minimize fill-in
     // clock_t startTime = clock();
-    if (!reorder(nrows, xadj, adjncy, perm, invp, nnzl))
+    if (nestedDissection) {
+      if (!reorderND(nrows, xadj, adjncy, perm, invp, nnzl))
+        break;
+    } else if (!reorder(nrows, xadj, adjncy, perm, invp, nnzl))
       break;
 
     /************ DEBUG  ******************
@@ -108,7 +180,8 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
     // ... allocate space for compressed storage of factorized matrix
     xlnz = new int[nrows + 1];
     xnzsub = new int[nrows + 1];
-    nzsub = new int[nnzl];
+    nnzsub = nnzl;
+    nzsub = new int[nnzsub];
     if (!xlnz || !xnzsub || !nzsub)
       break;
 
@@ -147,7 +220,16 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
 
   // ... map off-diag coeffs. of A to positions in xlnz
   aij2lnz(nnz, xrow, xcol, invp, xlnz, xnzsub, nzsub, xaij);
+  saveSymbolicFactor(xrow, xcol, nnzsub);
+  findSubtrees();
+  return allocNumericArrays() && allocUpdateArrays(xrow, xcol);
+}
 
+//-----------------------------------------------------------------------------
+
+//  Allocate the arrays used by the numerical factorization.
+
+int SparspakSolver::allocNumericArrays() {
   // ... allocate space for coeffs. of L and r.h.s vector
   lnz = new double[nnzl];
   diag = new double[nrows];
@@ -166,6 +248,110 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
 
 //-----------------------------------------------------------------------------
 
+//  Allocate the arrays used to update the factor of a previous matrix and
+//  record where each distinct off-diag. coeff. of A is stored.
+
+int SparspakSolver::allocUpdateArrays(int *xrow, int *xcol) {
+  // ... a mixed precision solver keeps its factor in single precision
+  //     until refinement stalls (see useDoubleFactor())
+  if (mixedPrecision) {
+    lfacSingle.resize(nnzl);
+    dfacSingle.resize(nrows);
+    rhsSingle.resize(nrows);
+    xRefined.resize(nrows);
+    residual.resize(nrows);
+  } else {
+    lfac = new double[nnzl];
+    dfac = new double[nrows];
+    if (!lfac || !dfac)
+      return 0;
+  }
+  dprev = new double[nrows];
+  work = new double[nrows];
+  marker = new int[nrows];
+  offPos = new int[nnz];
+  offRow = new int[nnz];
+  offCol = new int[nnz];
+  if (!dprev || !work || !marker || !offPos || !offRow || !offCol)
+    return 0;
+  memset(work, 0, nrows * sizeof(double));
+  memset(marker, 0, nrows * sizeof(int));
+
+  // ... parallel links share the same position in lnz
+  vector<bool> seen(nnzl, false);
+  nOffDiag = 0;
+  for (int j = 0; j < nnz; j++) {
+    int k = xaij[j] - 1;
+    if (k < 0 || seen[k])
+      continue;
+    seen[k] = true;
+    offPos[nOffDiag] = k;
+    offRow[nOffDiag] = invp[xrow[j]] - 1;
+    offCol[nOffDiag] = invp[xcol[j]] - 1;
+    nOffDiag++;
+  }
+  aprev = new double[nOffDiag + 1];
+  if (!aprev)
+    return 0;
+  factorValid = false;
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Copy the shared symbolic factorization if it was built for the same
+//  sparsity pattern (xrow, xcol).
+
+bool SparspakSolver::loadSymbolicFactor(int *xrow, int *xcol) {
+  if (!symbolic)
+    return false;
+  SymbolicFactor &shared = *symbolic;
+  lock_guard<mutex> lock(shared.mutex);
+  if (shared.nrows != nrows || (int)shared.xrow.size() != nnz ||
+      shared.nestedDissection != nestedDissection)
+    return false;
+  if (!equal(xrow, xrow + nnz, shared.xrow.begin()) ||
+      !equal(xcol, xcol + nnz, shared.xcol.begin()))
+    return false;
+
+  nnzl = shared.nnzl;
+  xlnz = new int[nrows + 1];
+  xnzsub = new int[nrows + 1];
+  nzsub = new int[shared.nzsub.size()];
+  copy(shared.perm.begin(), shared.perm.end(), perm);
+  copy(shared.invp.begin(), shared.invp.end(), invp);
+  copy(shared.xlnz.begin(), shared.xlnz.end(), xlnz);
+  copy(shared.xnzsub.begin(), shared.xnzsub.end(), xnzsub);
+  copy(shared.nzsub.begin(), shared.nzsub.end(), nzsub);
+  copy(shared.xaij.begin(), shared.xaij.end(), xaij);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Save the symbolic factorization of the current sparsity pattern for
+//  the other solvers sharing it.
+
+void SparspakSolver::saveSymbolicFactor(int *xrow, int *xcol, int nnzsub) {
+  if (!symbolic)
+    return;
+  SymbolicFactor &shared = *symbolic;
+  lock_guard<mutex> lock(shared.mutex);
+  shared.nrows = nrows;
+  shared.nnzl = nnzl;
+  shared.nestedDissection = nestedDissection;
+  shared.xrow.assign(xrow, xrow + nnz);
+  shared.xcol.assign(xcol, xcol + nnz);
+  shared.perm.assign(perm, perm + nrows);
+  shared.invp.assign(invp, invp + nrows);
+  shared.xlnz.assign(xlnz, xlnz + nrows + 1);
+  shared.xnzsub.assign(xnzsub, xnzsub + nrows + 1);
+  shared.nzsub.assign(nzsub, nzsub + nnzsub);
+  shared.xaij.assign(xaij, xaij + nnz);
+}
+
+//-----------------------------------------------------------------------------
+
 int SparspakSolver::solve(int n, double x[]) {
   // ... call sp_numfct to numerically evaluate the factorized matrix L
 
@@ -181,20 +367,17 @@ int SparspakSolver::solve(int n, double x[]) {
       ++diag;  ++rhs;  ++invp;
   *********************************************/
 
-  int flag;
-  sp_numfct(nrows, xlnz, lnz, xnzsub, nzsub, diag, link, first, temp, flag);
+  // ... refine a solution from the single precision factor; once that
+  //     stalls the solver keeps a double precision factor instead
 
-  // if the matrix was ill-conditioned, return the problematic row
-  if (flag) {
-    --invp;
-    flag = invp[flag] - 1;
-    ++invp;
-    return flag;
+  if (mixedPrecision && !solveMixed())
+    useDoubleFactor();
+  if (!mixedPrecision) {
+    int flag = factorAndSolve();
+    if (flag >= 0)
+      return flag;
   }
 
-  // call sp_solve() to solve the system LDL'x = b
-  sp_solve(nrows, xlnz, lnz, xnzsub, nzsub, diag, rhs);
-
   // transfer results from rhs to x (recognizing that rhs
   // arrays are offset by 1)
   --x;
@@ -211,6 +394,490 @@ int SparspakSolver::solve(int n, double x[]) {
 
 //-----------------------------------------------------------------------------
 
+//  Factorize A in double precision (or update the previous factor) and
+//  solve for x in place in rhs. Returns -1 if successful or the index of
+//  an ill-conditioned row.
+
+int SparspakSolver::factorAndSolve() {
+  // ... modify the factor of the previous matrix if only a few coeffs.
+  //     of A changed, otherwise factorize A from scratch
+
+  if (!updateFactor(lfac, dfac)) {
+    memcpy(lfac, lnz, nnzl * sizeof(double));
+    memcpy(dfac, diag, nrows * sizeof(double));
+    int flag;
+    if (nestedDissection)
+      flag = factorSubtrees(lfac, dfac);
+    else
+      sp_numfct(nrows, xlnz, lfac, xnzsub, nzsub, dfac, link, first, temp,
+                flag);
+
+    // if the matrix was ill-conditioned, return the problematic row
+    if (flag) {
+      factorValid = false;
+      --invp;
+      flag = invp[flag] - 1;
+      ++invp;
+      return flag;
+    }
+    updateCount = 0;
+  }
+
+  saveFactoredMatrix();
+
+  // call sp_solve() to solve the system LL'x = b
+  if (nestedDissection)
+    solveSubtrees(lfac, dfac, rhs);
+  else
+    sp_solve(nrows, xlnz, lfac, xnzsub, nzsub, dfac, rhs);
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Remember the matrix whose factor is held in lfac/dfac (or in
+//  lfacSingle/dfacSingle), so that the next one can be reached by updates.
+
+void SparspakSolver::saveFactoredMatrix() {
+  for (int k = 0; k < nOffDiag; k++)
+    aprev[k] = lnz[offPos[k]];
+  memcpy(dprev, diag, nrows * sizeof(double));
+  factorValid = true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Solve Ax = b with a single precision factor of A and iterative
+//  refinement. The factor of the previous matrix is updated when only a
+//  few coeffs. of A changed, as in double precision, and computed afresh
+//  otherwise (or if refinement stalls with an updated factor). Returns
+//  false, leaving A and b untouched, if the factor breaks down or the
+//  residual stops shrinking.
+
+bool SparspakSolver::solveMixed() {
+  bool updated = updateFactor(lfacSingle.data(), dfacSingle.data());
+  if (!updated && !factorSingle())
+    return false;
+  saveFactoredMatrix();
+  if (refineSolution())
+    return true;
+  return updated && factorSingle() && refineSolution();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Factorize A from scratch in single precision. Returns false if a pivot
+//  is not positive.
+
+bool SparspakSolver::factorSingle() {
+  for (int k = 0; k < nnzl; k++)
+    lfacSingle[k] = (float)lnz[k];
+  for (int i = 0; i < nrows; i++)
+    dfacSingle[i] = (float)diag[i];
+  updateCount = 0;
+  if (factorSubtrees(lfacSingle.data(), dfacSingle.data())) {
+    factorValid = false;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Refine x from the single precision factor: each correction solves
+//  L L'd = b - Ax with the residual computed in double precision from the
+//  assembled A. Refinement stops once the residual is as small as a double
+//  precision factor would leave it (max|b - Ax| <= max|A| max|x| eps
+//  sqrt(n)), and the solution is left in rhs. Returns false if the residual
+//  stops shrinking first.
+
+bool SparspakSolver::refineSolution() {
+  double aMax = 0.0;
+  for (int i = 0; i < nrows; i++)
+    aMax = max(aMax, fabs(diag[i]));
+  for (int k = 0; k < nOffDiag; k++)
+    aMax = max(aMax, fabs(lnz[offPos[k]]));
+  double residualTol = aMax * numeric_limits<double>::epsilon() * sqrt(nrows);
+
+  fill(xRefined.begin(), xRefined.end(), 0.0);
+  double rPrev = numeric_limits<double>::max();
+  for (int iter = 0; iter <= MaxRefinements; iter++) {
+    // ... residual b - Ax in double precision
+    double rMax = 0.0, xMax = 0.0;
+    for (int i = 0; i < nrows; i++)
+      residual[i] = rhs[i] - diag[i] * xRefined[i];
+    for (int k = 0; k < nOffDiag; k++) {
+      double a = lnz[offPos[k]];
+      residual[offRow[k]] -= a * xRefined[offCol[k]];
+      residual[offCol[k]] -= a * xRefined[offRow[k]];
+    }
+    for (int i = 0; i < nrows; i++) {
+      rMax = max(rMax, fabs(residual[i]));
+      xMax = max(xMax, fabs(xRefined[i]));
+    }
+    if (iter > 0 && rMax <= residualTol * xMax) {
+      memcpy(rhs, xRefined.data(), nrows * sizeof(double));
+      return true;
+    }
+    if (rMax > MinRefinementRate * rPrev)
+      break;
+    rPrev = rMax;
+
+    // ... correction from the single precision factor
+    for (int i = 0; i < nrows; i++)
+      rhsSingle[i] = (float)residual[i];
+    solveSubtrees(lfacSingle.data(), dfacSingle.data(), rhsSingle.data());
+    for (int i = 0; i < nrows; i++)
+      xRefined[i] += rhsSingle[i];
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Replace the single precision factor by a double precision one for good
+//  once refinement has stalled, so that later solves of similar matrices
+//  do not pay for both factorizations.
+
+void SparspakSolver::useDoubleFactor() {
+  mixedPrecision = false;
+  factorValid = false;
+  lfac = new double[nnzl];
+  dfac = new double[nrows];
+  vector<float>().swap(lfacSingle);
+  vector<float>().swap(dfacSingle);
+  vector<float>().swap(rhsSingle);
+  vector<double>().swap(xRefined);
+  vector<double>().swap(residual);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Bring the factor lf/df of the previous matrix up to date with the
+//  current one through rank-one updates and downdates. Returns false if the
+//  change is too large (or a downdate breaks down) and A must be
+//  refactorized.
+
+template <typename T> bool SparspakSolver::updateFactor(T lf[], T df[]) {
+  if (!factorValid || updateCount >= MaxUpdatesPerFactor)
+    return false;
+  size_t maxRank = max(MinUpdateRank, nrows / UpdateRankDivisor);
+
+  // ... a change d in off-diag. coeff. (r, s) is the rank-one change
+  //     -d * (e_r - e_s)(e_r - e_s)', which also changes diag r and s;
+  //     what is left of the diagonal change is made of rank-one terms
+
+  struct Update {
+    int r, s;
+    double delta;
+  };
+  vector<Update> updates;
+  for (int i = 0; i < nrows; i++)
+    temp[i] = diag[i] - dprev[i];
+  for (int k = 0; k < nOffDiag; k++) {
+    double d = lnz[offPos[k]] - aprev[k];
+    if (d == 0.0)
+      continue;
+    updates.push_back({offRow[k], offCol[k], -d});
+    temp[offRow[k]] += d;
+    temp[offCol[k]] += d;
+    if (updates.size() > maxRank)
+      break;
+  }
+  for (int i = 0; i < nrows && updates.size() <= maxRank; i++) {
+    if (temp[i] != 0.0)
+      updates.push_back({i, -1, temp[i]});
+  }
+  if (updates.size() > maxRank)
+    return false;
+
+  // ... apply updates before downdates so that every intermediate
+  //     matrix stays positive definite
+
+  stable_partition(updates.begin(), updates.end(),
+                   [](const Update &u) { return u.delta > 0.0; });
+  for (const Update &u : updates) {
+    if (!updateFactor(u.r, u.s, u.delta, lf, df))
+      return false;
+  }
+  updateCount += (int)updates.size();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Modify the factor L (lf/df) of A into that of A + delta * v * v', where
+//  v = e_r - e_s (or e_r if s < 0). Only the columns of L on the paths
+//  from r and s to the root of the elimination tree are affected.
+
+template <typename T>
+bool SparspakSolver::updateFactor(int r, int s, double delta, T lf[], T df[]) {
+  double sigma = delta > 0.0 ? 1.0 : -1.0;
+  double w = sqrt(fabs(delta));
+
+  // ... the parent of a column is the row of its first sub-diag. entry
+  vector<int> cols;
+  for (int start : {r, s}) {
+    for (int j = start; j >= 0 && !marker[j];) {
+      marker[j] = 1;
+      cols.push_back(j);
+      j = (xlnz[j + 1] > xlnz[j]) ? nzsub[xnzsub[j] - 1] - 1 : -1;
+    }
+  }
+  sort(cols.begin(), cols.end());
+
+  work[r] = w;
+  if (s >= 0)
+    work[s] = -w;
+
+  bool ok = true;
+  for (int j : cols) {
+    marker[j] = 0;
+    double x = work[j];
+    work[j] = 0.0;
+    if (!ok || x == 0.0)
+      continue;
+
+    double l = df[j];
+    double l2 = l * l + sigma * x * x;
+    if (l2 <= MinDiagRatio * l * l) {
+      ok = false;
+      continue;
+    }
+    double lnew = sqrt(l2);
+    double c = lnew / l;
+    double sn = x / l;
+    df[j] = (T)lnew;
+
+    int isub = xnzsub[j] - 1;
+    for (int ii = xlnz[j] - 1; ii < xlnz[j + 1] - 1; ii++, isub++) {
+      int i = nzsub[isub] - 1;
+      double lij = (lf[ii] + sigma * sn * work[i]) / c;
+      work[i] = c * work[i] - sn * lij;
+      lf[ii] = (T)lij;
+    }
+  }
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Split the elimination tree into subtrees of roughly equal work that can
+//  be factorized independently, and index the rows of L so that a column
+//  can be computed from the columns to its left.
+
+void SparspakSolver::findSubtrees() {
+  rowBeg.clear();
+  rowCol.clear();
+  rowPos.clear();
+  taskBeg.clear();
+  taskCols.clear();
+  topCols.clear();
+  if (!nestedDissection && !mixedPrecision)
+    return;
+
+  // ... row structure of L (columns in increasing order)
+
+  rowBeg.assign(nrows + 1, 0);
+  for (int j = 0; j < nrows; j++) {
+    int isub = xnzsub[j] - 1;
+    for (int p = xlnz[j] - 1; p < xlnz[j + 1] - 1; p++, isub++)
+      rowBeg[nzsub[isub]]++;
+  }
+  for (int i = 0; i < nrows; i++)
+    rowBeg[i + 1] += rowBeg[i];
+  rowCol.resize(rowBeg[nrows]);
+  rowPos.resize(rowBeg[nrows]);
+  vector<int> next(rowBeg.begin(), rowBeg.end() - 1);
+  for (int j = 0; j < nrows; j++) {
+    int isub = xnzsub[j] - 1;
+    for (int p = xlnz[j] - 1; p < xlnz[j + 1] - 1; p++, isub++) {
+      int i = nzsub[isub] - 1;
+      rowCol[next[i]] = j;
+      rowPos[next[i]] = p;
+      next[i]++;
+    }
+  }
+
+  // ... work below each column of the elimination tree (the parent of a
+  //     column is the row of its first sub-diag. entry)
+
+  vector<int> parent(nrows, -1);
+  vector<double> colWork(nrows, 0.0);
+  double totalWork = 0.0;
+  for (int j = 0; j < nrows; j++) {
+    int count = xlnz[j + 1] - xlnz[j];
+    if (count > 0)
+      parent[j] = nzsub[xnzsub[j] - 1] - 1;
+    colWork[j] += (count + 1.0) * (count + 1.0);
+    totalWork += (count + 1.0) * (count + 1.0);
+    if (parent[j] >= 0)
+      colWork[parent[j]] += colWork[j];
+  }
+
+  // ... a subtree is a task if its work is small enough and its parent's
+  //     is not; columns outside all tasks are left for last
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  double maxWork = totalWork / (threads * TasksPerThread);
+  vector<int> task(nrows, -1);
+  vector<double> taskWork;
+  for (int j = nrows - 1; j >= 0; j--) {
+    int pj = parent[j];
+    if (pj >= 0 && task[pj] >= 0)
+      task[j] = task[pj];
+    else if (colWork[j] <= maxWork) {
+      task[j] = (int)taskWork.size();
+      taskWork.push_back(colWork[j]);
+    }
+  }
+
+  // ... list the columns of each task, largest tasks first
+
+  int nTasks = (int)taskWork.size();
+  vector<int> rank(nTasks);
+  for (int t = 0; t < nTasks; t++)
+    rank[t] = t;
+  stable_sort(rank.begin(), rank.end(),
+              [&](int a, int b) { return taskWork[a] > taskWork[b]; });
+  vector<int> slot(nTasks);
+  for (int t = 0; t < nTasks; t++)
+    slot[rank[t]] = t;
+  taskBeg.assign(nTasks + 1, 0);
+  for (int j = 0; j < nrows; j++) {
+    if (task[j] >= 0)
+      taskBeg[slot[task[j]] + 1]++;
+    else
+      topCols.push_back(j);
+  }
+  for (int t = 0; t < nTasks; t++)
+    taskBeg[t + 1] += taskBeg[t];
+  taskCols.resize(taskBeg[nTasks]);
+  next.assign(taskBeg.begin(), taskBeg.end() - 1);
+  for (int j = 0; j < nrows; j++) {
+    if (task[j] >= 0)
+      taskCols[next[slot[task[j]]]++] = j;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Numerically factorize the subtrees concurrently and then the columns
+//  above them. l and d hold A on entry and L on exit. Returns 0 if
+//  successful or the (1-based) column with a non-positive pivot, like
+//  sp_numfct.
+
+template <typename T> int SparspakSolver::factorSubtrees(T l[], T d[]) {
+  int flag = 0;
+  int nTasks = (int)taskBeg.size() - 1;
+#pragma omp parallel if (nrows >= parallelRows && nTasks > 1)
+  {
+    vector<T> w(nrows, 0);
+#pragma omp for schedule(dynamic)
+    for (int t = 0; t < nTasks; t++) {
+      for (int m = taskBeg[t]; m < taskBeg[t + 1]; m++) {
+        int j = taskCols[m];
+        if (!factorColumn(j, l, d, w.data())) {
+#pragma omp critical
+          flag = (flag == 0) ? j + 1 : min(flag, j + 1);
+          break;
+        }
+      }
+    }
+  }
+  if (flag)
+    return flag;
+
+  vector<T> w(nrows, 0);
+  for (int j : topCols) {
+    if (!factorColumn(j, l, d, w.data()))
+      return j + 1;
+  }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Compute column j of L from the columns k < j with L[j,k] != 0, which are
+//  all in the subtree below j. w is a zeroed work vector of length nrows.
+
+template <typename T>
+bool SparspakSolver::factorColumn(int j, T l[], T d[], T w[]) {
+  int beg = xlnz[j] - 1;
+  int end = xlnz[j + 1] - 1;
+  int sub = xnzsub[j] - 1;
+  for (int p = beg; p < end; p++)
+    w[nzsub[sub + p - beg] - 1] = l[p];
+
+  T djj = d[j];
+  for (int r = rowBeg[j]; r < rowBeg[j + 1]; r++) {
+    int k = rowCol[r];
+    int p = rowPos[r];
+    T ljk = l[p];
+    djj -= ljk * ljk;
+    int isub = xnzsub[k] - 1 + (p + 1 - (xlnz[k] - 1));
+    for (int q = p + 1; q < xlnz[k + 1] - 1; q++, isub++)
+      w[nzsub[isub] - 1] -= l[q] * ljk;
+  }
+
+  bool ok = djj > 0;
+  djj = ok ? sqrt(djj) : 1;
+  d[j] = djj;
+  for (int p = beg; p < end; p++) {
+    int i = nzsub[sub + p - beg] - 1;
+    l[p] = w[i] / djj;
+    w[i] = 0;
+  }
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Solve L L'x = b in place in b. The forward substitution runs through
+//  the subtrees concurrently and then the columns above them; the backward
+//  substitution runs in the opposite direction.
+
+template <typename T>
+void SparspakSolver::solveSubtrees(const T l[], const T d[], T b[]) {
+  int nTasks = (int)taskBeg.size() - 1;
+  bool parallel = nrows >= parallelRows && nTasks > 1;
+
+  auto forward = [&](int j) {
+    T s = b[j];
+    for (int r = rowBeg[j]; r < rowBeg[j + 1]; r++)
+      s -= l[rowPos[r]] * b[rowCol[r]];
+    b[j] = s / d[j];
+  };
+  auto backward = [&](int j) {
+    T s = b[j];
+    int isub = xnzsub[j] - 1;
+    for (int p = xlnz[j] - 1; p < xlnz[j + 1] - 1; p++, isub++)
+      s -= l[p] * b[nzsub[isub] - 1];
+    b[j] = s / d[j];
+  };
+
+#pragma omp parallel for schedule(dynamic) if (parallel)
+  for (int t = 0; t < nTasks; t++) {
+    for (int m = taskBeg[t]; m < taskBeg[t + 1]; m++)
+      forward(taskCols[m]);
+  }
+  for (int j : topCols)
+    forward(j);
+
+  for (int m = (int)topCols.size() - 1; m >= 0; m--)
+    backward(topCols[m]);
+#pragma omp parallel for schedule(dynamic) if (parallel)
+  for (int t = 0; t < nTasks; t++) {
+    for (int m = taskBeg[t + 1] - 1; m >= taskBeg[t]; m--)
+      backward(taskCols[m]);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 void SparspakSolver::reset() {
   memset(diag, 0, (nrows) * sizeof(double));
   memset(lnz, 0, (nnzl) * sizeof(double));
@@ -480,6 +1147,54 @@ int reorder(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl) {
 
 //-----------------------------------------------------------------------------
 
+//  Re-order the rows of the matrix by nested dissection and count the
+//  non-zeros of its factor, which bound the subscripts stored by the
+//  symbolic factorization.
+
+int reorderND(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl) {
+  // ... 0-based copy of the adjacency lists
+  vector<int> xadj0(n + 1);
+  vector<int> adjncy0(xadj[n] - 1);
+  for (int i = 0; i <= n; i++)
+    xadj0[i] = xadj[i] - 1;
+  for (int m = 0; m < xadj[n] - 1; m++)
+    adjncy0[m] = adjncy[m] - 1;
+
+  vector<int> order;
+  Graph::nestedDissection(n, xadj0.data(), adjncy0.data(), order);
+  if ((int)order.size() != n)
+    return 0;
+  for (int k = 0; k < n; k++) {
+    perm[k] = order[k] + 1;
+    invp[order[k]] = k + 1;
+  }
+
+  // ... the non-zeros of row k of L are the columns on the paths of the
+  //     elimination tree from the non-zeros of row k of A up to k
+  vector<int> parent(n, -1);
+  vector<int> mark(n, -1);
+  nnzl = 0;
+  for (int k = 0; k < n; k++) {
+    mark[k] = k;
+    int v = order[k];
+    for (int m = xadj0[v]; m < xadj0[v + 1]; m++) {
+      int j = invp[adjncy0[m]] - 1;
+      if (j >= k)
+        continue;
+      while (mark[j] != k) {
+        mark[j] = k;
+        nnzl++;
+        if (parent[j] < 0)
+          parent[j] = k;
+        j = parent[j];
+      }
+    }
+  }
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+
 //  Symbolically factorize the matrix
 
 int factorize(int n, int &nnzl, int *xadj, int *adjncy, int *perm, int *invp,
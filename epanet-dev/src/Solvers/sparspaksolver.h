@@ -14,6 +14,25 @@
 
 #include "matrixsolver.h"
 
+#include <mutex>
+
+//! \struct SymbolicFactor
+//! \brief The symbolic factorization of a sparsity pattern.
+//!
+//! The solvers of projects that load the same network (e.g. one per
+//! branch-and-bound thread or per rolling-horizon re-plan) can share one
+//! of these, so that only the first of them orders and symbolically
+//! factorizes the matrix.
+
+struct SymbolicFactor {
+  std::mutex mutex;
+  int nrows = 0;
+  int nnzl = 0;
+  bool nestedDissection = false;
+  std::vector<int> xrow, xcol; // sparsity pattern of A
+  std::vector<int> perm, invp, xlnz, xnzsub, nzsub, xaij;
+};
+
 //! \class SparspakSolver
 //! \brief Solves Ax = b using the SPARSPAK routines.
 //!
@@ -22,8 +41,20 @@
 //! and Liu, for re-ordering, factorizing, and solving via Cholesky
 //! decomposition a sparse, symmetric, positive definite set of linear
 //! equations Ax = b.
+//!
+//! The rows are ordered by multiple minimum degree unless nested dissection
+//! is chosen. In that case the factorization and the triangular solves
+//! process the independent subtrees of the elimination tree concurrently
+//! and then the separator columns above them. In mixed precision mode the
+//! factor is computed, updated and applied in single precision and the
+//! solution is brought to double precision accuracy by iterative
+//! refinement against the assembled A. The first time refinement stalls
+//! the solver switches to a double precision factor for good, so MIXED
+//! only pays off on networks whose matrices refine reliably.
 
 class SparspakSolver : public MatrixSolver {
+  friend class SparspakLanes;
+
 public:
   // Constructor/Destructor
 
@@ -46,6 +77,17 @@ public:
   void addToRhs(int i, double b);
   int solve(int n, double x[]);
 
+  void setOrdering(const std::string &ordering);
+  void setPrecision(const std::string &precision);
+  void setParallelRows(int rows);
+  void shareSymbolicFactor(std::shared_ptr<SymbolicFactor> cache);
+
+  double *diagStorage() { return diag; }
+  double *offDiagStorage() { return lnz; }
+  double *rhsStorage() { return rhs; }
+  int diagIndex(int i) { return invp[i] - 1; }
+  int offDiagIndex(int j) { return xaij[j] - 1; }
+
   //! Serialize to JSON for SparspakSolver
   nlohmann::json to_json() const override {
     return {
@@ -115,6 +157,59 @@ private:
   double *rhs;  // right hand side vector
   double *temp; // work array
   std::ostream &msgLog;
+  std::shared_ptr<SymbolicFactor> symbolic; // shared symbolic factorization
+
+  // Cholesky factor kept apart from A so that it can be modified by
+  // low-rank updates when only a few coeffs. of A change between solves
+  double *lfac;     // off-diag. coeffs. of the factor L of the last A
+  double *dfac;     // diagonal of L (both null while in mixed precision)
+  double *aprev;    // distinct off-diag. coeffs. of the last factorized A
+  double *dprev;    // diagonal of the last factorized A
+  double *work;     // work vector for factor updates
+  int *marker;      // work array marking the columns of an update
+  int nOffDiag;     // number of distinct off-diag. positions of A in lnz
+  int *offPos;      // position in lnz of each distinct off-diag. coeff.
+  int *offRow;      // permuted row of each distinct off-diag. coeff.
+  int *offCol;      // permuted column of each distinct off-diag. coeff.
+  int updateCount;  // factor updates applied since the last refactorization
+  bool factorValid; // true if the factor is that of aprev/dprev
+
+  // Independent subtrees of the elimination tree (nested dissection only)
+  bool nestedDissection;     // rows are ordered by nested dissection
+  int parallelRows;          // rows needed to process subtrees on threads
+  std::vector<int> rowBeg;   // start of each row of L in rowCol/rowPos
+  std::vector<int> rowCol;   // column of each off-diag. coeff. in a row of L
+  std::vector<int> rowPos;   // position of that coeff. in lfac
+  std::vector<int> taskBeg;  // start of each subtree in taskCols
+  std::vector<int> taskCols; // columns of each subtree, in increasing order
+  std::vector<int> topCols;  // columns above all subtrees, in increasing order
+
+  // Single precision factor, used instead of lfac/dfac (mixed precision
+  // only, until refinement stalls)
+  bool mixedPrecision;            // factor in single precision and refine
+  std::vector<float> lfacSingle;  // off-diag. coeffs. of L
+  std::vector<float> dfacSingle;  // diagonal of L
+  std::vector<float> rhsSingle;   // residual, then correction to x
+  std::vector<double> xRefined;   // solution being refined
+  std::vector<double> residual;   // b - Ax in double precision
+
+  bool loadSymbolicFactor(int *xrow, int *xcol);
+  void saveSymbolicFactor(int *xrow, int *xcol, int nnzsub);
+  int allocNumericArrays();
+  int allocUpdateArrays(int *xrow, int *xcol);
+  template <typename T> bool updateFactor(T lf[], T df[]);
+  template <typename T>
+  bool updateFactor(int r, int s, double delta, T lf[], T df[]);
+  void saveFactoredMatrix();
+  int factorAndSolve();
+  bool solveMixed();
+  bool factorSingle();
+  bool refineSolution();
+  void useDoubleFactor();
+  void findSubtrees();
+  template <typename T> int factorSubtrees(T l[], T d[]);
+  template <typename T> bool factorColumn(int j, T l[], T d[], T w[]);
+  template <typename T> void solveSubtrees(const T l[], const T d[], T b[]);
 };
 
 #endif
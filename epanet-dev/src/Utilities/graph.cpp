@@ -18,6 +18,9 @@
 #include "Elements/link.h"
 #include "Elements/node.h"
 
+#include <algorithm>
+#include <queue>
+
 #include <vector>
 using namespace std;
 
@@ -64,3 +67,248 @@ void Graph::createAdjLists(Network *nw) {
     throw;
   }
 }
+
+//-----------------------------------------------------------------------------
+
+//  Peel the tree branches of the network. A junction can be peeled once a
+//  single link is left at it, unless it belongs to a valve (whose end nodes
+//  may become fixed grade). Tanks and reservoirs always stay in the core.
+
+void Graph::findForestCore(Network *nw) {
+  createAdjLists(nw);
+  int nodeCount = nw->count(Element::NODE);
+  int linkCount = nw->count(Element::LINK);
+
+  vector<bool> peelable(nodeCount, false);
+  for (Node *node : nw->nodes)
+    peelable[node->index] = (node->type() == Node::JUNCTION);
+  for (Link *link : nw->links) {
+    if (link->type() == Link::VALVE) {
+      peelable[link->fromNode->index] = false;
+      peelable[link->toNode->index] = false;
+    }
+  }
+
+  vector<int> degree(nodeCount);
+  for (int i = 0; i < nodeCount; i++)
+    degree[i] = adjListBeg[i + 1] - adjListBeg[i];
+  vector<bool> linkPeeled(linkCount, false);
+
+  queue<int> leaves;
+  for (int i = 0; i < nodeCount; i++) {
+    if (peelable[i] && degree[i] == 1)
+      leaves.push(i);
+  }
+
+  treeNodes.clear();
+  treeLinks.clear();
+  while (!leaves.empty()) {
+    int i = leaves.front();
+    leaves.pop();
+    if (degree[i] != 1)
+      continue;
+
+    // ... find the only link left at the leaf
+    int k = -1;
+    for (int m = adjListBeg[i]; m < adjListBeg[i + 1]; m++) {
+      if (!linkPeeled[adjLists[m]]) {
+        k = adjLists[m];
+        break;
+      }
+    }
+    Link *link = nw->link(k);
+    int j = (link->fromNode->index == i) ? link->toNode->index
+                                         : link->fromNode->index;
+    linkPeeled[k] = true;
+    degree[i] = 0;
+    degree[j]--;
+    treeNodes.push_back(i);
+    treeLinks.push_back(k);
+    if (peelable[j] && degree[j] == 1)
+      leaves.push(j);
+  }
+
+  // ... number the nodes and links left in the core
+  coreNodes.clear();
+  coreLinks.clear();
+  coreNodeIndex.assign(nodeCount, -1);
+  coreLinkIndex.assign(linkCount, -1);
+  vector<bool> nodePeeled(nodeCount, false);
+  for (int i : treeNodes)
+    nodePeeled[i] = true;
+  for (int i = 0; i < nodeCount; i++) {
+    if (nodePeeled[i])
+      continue;
+    coreNodeIndex[i] = (int)coreNodes.size();
+    coreNodes.push_back(i);
+  }
+  for (int k = 0; k < linkCount; k++) {
+    if (linkPeeled[k])
+      continue;
+    coreLinkIndex[k] = (int)coreLinks.size();
+    coreLinks.push_back(k);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Nested dissection.
+//
+//  A subgraph is split by a breadth-first level structure rooted at a
+//  pseudo-peripheral vertex: the vertices of the median level that touch
+//  the next level form the separator, the levels before it (with the rest
+//  of the median level) form one part and the levels after it the other.
+//  Both parts are dissected recursively and ordered before the separator.
+//  Disconnected pieces are dissected separately and small pieces are left
+//  in their breadth-first order.
+
+namespace {
+
+const int LeafSize = 16;    // pieces this small are not dissected
+const int MaxRootTrials = 4; // searches for a pseudo-peripheral vertex
+
+struct Dissection {
+  const int *xadj;
+  const int *adjncy;
+  vector<int> owner;   // piece each vertex currently belongs to
+  vector<int> level;   // level of each vertex in the last level structure
+  vector<int> visited; // stamp of the last search that reached a vertex
+  vector<int> queue;   // vertices of the last search, in level order
+  vector<int> &order;
+  int pieces;
+  int stamp;
+
+  Dissection(int n, const int xadj_[], const int adjncy_[],
+             vector<int> &order_)
+      : xadj(xadj_), adjncy(adjncy_), owner(n, 0), level(n, 0),
+        visited(n, 0), order(order_), pieces(1), stamp(0) {}
+
+  int search(int root, int piece);
+  void dissect(vector<int> &verts, int piece);
+};
+
+//  Build the level structure of a piece rooted at vertex root; returns the
+//  index of its last level.
+
+int Dissection::search(int root, int piece) {
+  stamp++;
+  queue.clear();
+  queue.push_back(root);
+  visited[root] = stamp;
+  level[root] = 0;
+  for (size_t q = 0; q < queue.size(); q++) {
+    int v = queue[q];
+    for (int m = xadj[v]; m < xadj[v + 1]; m++) {
+      int u = adjncy[m];
+      if (owner[u] != piece || visited[u] == stamp)
+        continue;
+      visited[u] = stamp;
+      level[u] = level[v] + 1;
+      queue.push_back(u);
+    }
+  }
+  return level[queue.back()];
+}
+
+void Dissection::dissect(vector<int> &verts, int piece) {
+  if ((int)verts.size() <= LeafSize) {
+    order.insert(order.end(), verts.begin(), verts.end());
+    return;
+  }
+
+  // ... dissect each connected piece on its own
+
+  int depth = search(verts[0], piece);
+  if (queue.size() < verts.size()) {
+    vector<vector<int>> components;
+    vector<int> componentPieces;
+    for (int v : verts) {
+      if (owner[v] != piece)
+        continue;
+      search(v, piece);
+      componentPieces.push_back(pieces++);
+      for (int u : queue)
+        owner[u] = componentPieces.back();
+      components.push_back(queue);
+    }
+    for (size_t c = 0; c < components.size(); c++)
+      dissect(components[c], componentPieces[c]);
+    return;
+  }
+
+  // ... move the root to a pseudo-peripheral vertex: one of least degree
+  //     in the last level, as long as the structure gets deeper
+
+  int root = verts[0];
+  for (int trial = 0; trial < MaxRootTrials; trial++) {
+    int best = -1;
+    for (int q = (int)queue.size() - 1; q >= 0; q--) {
+      int v = queue[q];
+      if (level[v] < depth)
+        break;
+      if (best < 0 || xadj[v + 1] - xadj[v] < xadj[best + 1] - xadj[best])
+        best = v;
+    }
+    int depth2 = search(best, piece);
+    if (depth2 <= depth) {
+      search(root, piece);
+      break;
+    }
+    root = best;
+    depth = depth2;
+  }
+
+  if (depth < 2) {
+    order.insert(order.end(), queue.begin(), queue.end());
+    return;
+  }
+
+  // ... the separator level is the first one reaching half of the vertices,
+  //     kept away from both ends of the level structure
+
+  int half = (int)queue.size() / 2;
+  int sepLevel = level[queue[half]];
+  sepLevel = max(1, min(depth - 1, sepLevel));
+
+  vector<int> part1, part2, separator;
+  for (int v : queue) {
+    if (level[v] < sepLevel)
+      part1.push_back(v);
+    else if (level[v] > sepLevel)
+      part2.push_back(v);
+    else {
+      bool touchesNext = false;
+      for (int m = xadj[v]; m < xadj[v + 1] && !touchesNext; m++) {
+        int u = adjncy[m];
+        touchesNext = owner[u] == piece && level[u] == sepLevel + 1;
+      }
+      (touchesNext ? separator : part1).push_back(v);
+    }
+  }
+
+  int piece1 = pieces++;
+  int piece2 = pieces++;
+  for (int v : part1)
+    owner[v] = piece1;
+  for (int v : part2)
+    owner[v] = piece2;
+  for (int v : separator)
+    owner[v] = -1;
+  dissect(part1, piece1);
+  dissect(part2, piece2);
+  order.insert(order.end(), separator.begin(), separator.end());
+}
+
+} // namespace
+
+void Graph::nestedDissection(int n, const int xadj[], const int adjncy[],
+                             vector<int> &order) {
+  order.clear();
+  order.reserve(n);
+  Dissection nd(n, xadj, adjncy, order);
+  vector<int> verts(n);
+  for (int i = 0; i < n; i++)
+    verts[i] = i;
+  if (n > 0)
+    nd.dissect(verts, 0);
+}
@@ -30,6 +30,27 @@ public:
 
   void createAdjLists(Network *nw);
 
+  // Forest-core decomposition: junctions on tree branches are peeled off
+  // leaf first so that only the looped core enters the matrix solver.
+  void findForestCore(Network *nw);
+  int coreNodeCount() const { return (int)coreNodes.size(); }
+  int coreLinkCount() const { return (int)coreLinks.size(); }
+
+  // Nested dissection ordering of a sparse symmetric matrix whose
+  // off-diagonal structure is given by 0-based adjacency lists. Each
+  // subgraph is split by a level-structure separator that is ordered after
+  // both halves, so the halves become independent subtrees of the
+  // elimination tree. order[k] is the row eliminated k-th.
+  static void nestedDissection(int n, const int xadj[], const int adjncy[],
+                               std::vector<int> &order);
+
+  std::vector<int> treeNodes;     // peeled junctions, leaves first
+  std::vector<int> treeLinks;     // link joining each peeled junction to its parent
+  std::vector<int> coreNodes;     // network index of each core node
+  std::vector<int> coreLinks;     // network index of each core link
+  std::vector<int> coreNodeIndex; // core index of each network node (-1 if peeled)
+  std::vector<int> coreLinkIndex; // core index of each network link (-1 if peeled)
+
 private:
   std::vector<int> adjLists;   // packed nodal adjacency lists
   std::vector<int> adjListBeg; // starting index of each node's list
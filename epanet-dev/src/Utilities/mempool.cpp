@@ -122,3 +122,16 @@ void MemPool::reset() {
   current = first;
   current->free = current->block;
 }
+
+/*
+**  size()
+**
+**  Return the number of bytes held by the pool's blocks.
+*/
+
+std::size_t MemPool::size() const {
+  std::size_t bytes = 0;
+  for (MemBlock *memBlock = first; memBlock; memBlock = memBlock->next)
+    bytes += ALLOC_BLOCK_SIZE;
+  return bytes;
+}
@@ -25,6 +25,7 @@ public:
   ~MemPool();
   char *alloc(std::size_t size);
   void reset();
+  std::size_t size() const;
 
 private:
   MemBlock *first;
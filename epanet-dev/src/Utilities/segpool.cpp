@@ -19,6 +19,7 @@ SegPool::SegPool() {
   memPool = new MemPool();
   freeSeg = nullptr;
   segCount = 0;
+  freeCount = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -33,6 +34,7 @@ SegPool::~SegPool() {
 
 void SegPool::init() {
   segCount = 0;
+  freeCount = 0;
   memPool->reset();
   freeSeg = nullptr;
 }
@@ -45,6 +47,7 @@ Segment *SegPool::getSegment(double v, double c) {
   if (freeSeg) {
     seg = freeSeg;
     freeSeg = seg->next;
+    freeCount--;
   }
 
   // ... otherwise create a new one from the memory pool
@@ -67,4 +70,11 @@ Segment *SegPool::getSegment(double v, double c) {
 void SegPool::freeSegment(Segment *seg) {
   seg->next = freeSeg;
   freeSeg = seg;
+  freeCount++;
 }
+
+//-----------------------------------------------------------------------------
+
+//  Memory reserved for segments, in bytes.
+
+double SegPool::bytes() const { return (double)memPool->size(); }
@@ -31,8 +31,13 @@ public:
   Segment *getSegment(double v, double c);
   void freeSegment(Segment *seg);
 
+  int liveSegments() const { return segCount - freeCount; }
+  int freeSegments() const { return freeCount; }
+  double bytes() const;
+
 private:
   int segCount;     // number of volume segments allocated
+  int freeCount;    // number of segments on the free list
   Segment *freeSeg; // first unused segment
   MemPool *memPool; // memory pool for volume segments
 };
@@ -221,6 +221,8 @@ int EN_getLinkType(int, int *, EN_Project);
 int EN_getLinkNodes(int, int *, int *, EN_Project);
 int EN_getLinkValue(int, int, double *, EN_Project);
 
+int EN_getSegmentStats(int *, int *, double *, EN_Project);
+
 //==================================================================================
 /*        TO BE ADDED
 